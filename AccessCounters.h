@@ -0,0 +1,166 @@
+/**
+ * @file AccessCounters.h
+ * @brief Counts lookups per key and per gap, and turns the counts into new p and q.
+ *
+ * The counters are relaxed atomics, optionally split into shards so threads
+ * counting at the same time mostly write to different cache lines.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include "Vector.h"
+#include "Tree.h"
+
+/**
+ * @class AccessCounters
+ * @brief Hit counters for keys 1..n and miss counters for gaps 0..n.
+ *
+ * Each thread always counts into the same shard; reading a counter sums the shards.
+ * Memory use is shards * (2n + 2) * 8 bytes, so keep one shard for huge key sets.
+ */
+class AccessCounters
+{
+private:
+  int n;
+  int shards;
+  size_t stride; // Counters per shard, rounded up to whole cache lines
+  std::unique_ptr<std::atomic<uint64_t>[]> counts;
+
+  // Layout of a shard: hits of keys 0..n (0 unused), then misses of gaps 0..n
+  std::atomic<uint64_t> &hitCounter(int shard, int index) const
+  {
+    return counts[shard * stride + index];
+  }
+
+  std::atomic<uint64_t> &missCounter(int shard, int gap) const
+  {
+    return counts[shard * stride + (n + 1) + gap];
+  }
+
+  int shardOfThisThread() const
+  {
+    if (shards == 1)
+      return 0;
+    static thread_local size_t hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return int(hash % shards);
+  }
+
+  uint64_t sum(bool hit, int index, bool reset) const
+  {
+    uint64_t total = 0;
+    for (int s = 0; s < shards; s++)
+    {
+      std::atomic<uint64_t> &counter = hit ? hitCounter(s, index) : missCounter(s, index);
+      total += reset ? counter.exchange(0, std::memory_order_relaxed) : counter.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+public:
+  /**
+   * @param keys Number of keys n.
+   * @param shards Number of shards (default: 1, plain shared atomics).
+   */
+  explicit AccessCounters(int keys, int shards = 1)
+      : n(keys < 0 ? 0 : keys), shards(shards < 1 ? 1 : shards)
+  {
+    const size_t perLine = 64 / sizeof(std::atomic<uint64_t>);
+    stride = ((2 * size_t(n) + 2 + perLine - 1) / perLine) * perLine;
+    counts.reset(new std::atomic<uint64_t>[stride * this->shards]);
+    for (size_t i = 0; i < stride * this->shards; i++)
+      counts[i].store(0, std::memory_order_relaxed);
+  }
+
+  AccessCounters(const AccessCounters &) = delete;
+  AccessCounters &operator=(const AccessCounters &) = delete;
+
+  int size() const
+  {
+    return n;
+  }
+
+  // Counts a successful lookup of key `index` (1..n)
+  void recordHit(int index)
+  {
+    if (index >= 1 && index <= n)
+      hitCounter(shardOfThisThread(), index).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Counts an unsuccessful lookup that fell in gap `gap` (0..n)
+  void recordMiss(int gap)
+  {
+    if (gap >= 0 && gap <= n)
+      missCounter(shardOfThisThread(), gap).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Counts the outcome of a `Tree::find`
+  void record(const LookupResult &result)
+  {
+    if (result.node)
+      recordHit(result.node->index);
+    else
+      recordMiss(result.gap);
+  }
+
+  uint64_t hits(int index) const
+  {
+    return sum(true, index, false);
+  }
+
+  uint64_t misses(int gap) const
+  {
+    return sum(false, gap, false);
+  }
+
+  uint64_t total() const
+  {
+    uint64_t result = 0;
+    for (int i = 1; i <= n; i++)
+      result += hits(i);
+    for (int k = 0; k <= n; k++)
+      result += misses(k);
+    return result;
+  }
+
+  void reset()
+  {
+    for (size_t i = 0; i < stride * shards; i++)
+      counts[i].store(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Turns the counts into probabilities in the layout `OBST::generateTheOBST` expects.
+   *
+   * P gets n + 1 entries with P[0] = 0 and P[i] the share of lookups that found key i,
+   * Q gets n + 1 entries with Q[k] the share of lookups that fell in gap k.
+   * Both are all zeros if nothing was counted.
+   *
+   * @param reset Whether to clear the counters while reading them.
+   * @return The number of lookups the probabilities are based on.
+   */
+  uint64_t exportProbabilities(Vector<float> &P, Vector<float> &Q, bool reset = false)
+  {
+    P.resize(n + 1);
+    Q.resize(n + 1);
+    Vector<uint64_t> hitCounts(n + 1), missCounts(n + 1);
+
+    uint64_t total = 0;
+    for (int i = 1; i <= n; i++)
+      total += hitCounts[i] = sum(true, i, reset);
+    for (int k = 0; k <= n; k++)
+      total += missCounts[k] = sum(false, k, reset);
+
+    double scale = (total == 0) ? 0.0 : 1.0 / double(total);
+    P[0] = 0;
+    for (int i = 1; i <= n; i++)
+      P[i] = float(hitCounts[i] * scale);
+    for (int k = 0; k <= n; k++)
+      Q[k] = float(missCounts[k] * scale);
+    return total;
+  }
+};
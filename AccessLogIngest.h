@@ -0,0 +1,171 @@
+/**
+ * @file AccessLogIngest.h
+ * @brief Derives p and q from raw access logs (one looked-up key per line).
+ */
+
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Vector.h"
+#include "Utils.h"
+#include "TaskPool.h"
+#include "DataLoader.h"
+
+/**
+ * @class AccessLogIngest
+ * @brief Counts the lookups of a log against a sorted label set and normalizes them into P and Q.
+ *
+ * The log is split into chunks at line boundaries, and every chunk counts its keys in its
+ * own hash map (no sharing between threads). The maps are merged at the end, then each
+ * distinct key is placed once: a label it matches gets a hit, any other key is a miss
+ * in the gap found by binary search over the labels.
+ */
+class AccessLogIngest
+{
+public:
+  // Logs smaller than this are counted by the calling thread alone
+  static constexpr size_t PARALLEL_INGEST_BYTES = 1 << 20;
+
+private:
+  using CountMap = std::unordered_map<std::string_view, uint64_t>;
+
+  // Counts every non-empty line of `text` (a trailing '\r' is dropped)
+  static void countChunk(std::string_view text, CountMap &counts)
+  {
+    const char *cursor = text.data();
+    const char *end = text.data() + text.size();
+    while (cursor < end)
+    {
+      const char *newline = static_cast<const char *>(std::memchr(cursor, '\n', size_t(end - cursor)));
+      const char *lineEnd = newline ? newline : end;
+      std::string_view key(cursor, size_t(lineEnd - cursor));
+      cursor = newline ? newline + 1 : end;
+
+      if (!key.empty() && key.back() == '\r')
+        key.remove_suffix(1);
+      if (!key.empty())
+        counts[key]++;
+    }
+  }
+
+  // Number of labels smaller than `key`, i.e. the position it would be inserted at
+  static size_t lowerBound(const Vector<std::string> &labels, std::string_view key)
+  {
+    size_t begin = 0, end = labels.size();
+    while (begin < end)
+    {
+      size_t mid = begin + (end - begin) / 2;
+      if (Utils::compareStrings(labels[mid], key) < 0)
+        begin = mid + 1;
+      else
+        end = mid;
+    }
+    return begin;
+  }
+
+public:
+  /**
+   * @brief Counts the keys in `log` and turns the counts into probabilities.
+   *
+   * @param log The log contents, one looked-up key per line.
+   * @param labels Names of the keys, sorted with `Utils::compareStrings`.
+   * @param P Output: P[0] = 0 and P[i] the share of lookups that found labels[i - 1].
+   * @param Q Output: Q[k] the share of lookups that fell between labels[k - 1] and labels[k].
+   * @param threads Number of chunks counted in parallel (0: one per worker of the shared pool).
+   * @return The number of lookups counted (P and Q are all zeros if none).
+   */
+  static uint64_t ingest(std::string_view log, const Vector<std::string> &labels, Vector<float> &P, Vector<float> &Q,
+                         int threads = 0)
+  {
+    size_t n = labels.size();
+    TaskPool &pool = TaskPool::shared();
+
+    size_t chunkCount = 1;
+    if (log.size() >= PARALLEL_INGEST_BYTES)
+      chunkCount = (threads > 0) ? size_t(threads) : size_t(pool.size()) + 1;
+
+    // Count each chunk in its own map
+    Vector<std::string_view> parts = DataLoader::splitAtLines(log, chunkCount);
+    Vector<CountMap> counts(chunkCount);
+    if (chunkCount == 1)
+    {
+      countChunk(parts[0], counts[0]);
+    }
+    else
+    {
+      TaskGroup group(pool);
+      for (size_t c = 0; c < chunkCount; c++)
+      {
+        std::string_view part = parts[c];
+        CountMap *map = &counts[c];
+        group.run([part, map]
+                  { countChunk(part, *map); });
+      }
+      group.wait();
+    }
+
+    // Merge the maps into the first one
+    CountMap &merged = counts[0];
+    for (size_t c = 1; c < chunkCount; c++)
+    {
+      for (const auto &entry : counts[c])
+        merged[entry.first] += entry.second;
+      counts[c] = CountMap();
+    }
+
+    // Place each distinct key once: a hit on its label or a miss in its gap
+    Vector<uint64_t> hits(n + 1), misses(n + 1);
+    for (size_t i = 0; i <= n; i++)
+      hits[i] = misses[i] = 0;
+
+    uint64_t total = 0;
+    for (const auto &entry : merged)
+    {
+      size_t position = lowerBound(labels, entry.first);
+      if (position < n && Utils::compareStrings(labels[position], entry.first) == 0)
+        hits[position + 1] += entry.second;
+      else
+        misses[position] += entry.second;
+      total += entry.second;
+    }
+
+    double scale = (total == 0) ? 0.0 : 1.0 / double(total);
+    P.resize(n + 1);
+    Q.resize(n + 1);
+    P[0] = 0;
+    for (size_t i = 1; i <= n; i++)
+      P[i] = float(hits[i] * scale);
+    for (size_t k = 0; k <= n; k++)
+      Q[k] = float(misses[k] * scale);
+    return total;
+  }
+
+  /**
+   * @brief Counts the keys of a log file (see `ingest`), the file is memory-mapped.
+   *
+   * @param lookups If not null, set to the number of lookups counted.
+   * @return true on success; on failure the error is printed.
+   */
+  static bool ingestFile(const std::string &filename, const Vector<std::string> &labels, Vector<float> &P, Vector<float> &Q,
+                         uint64_t *lookups = nullptr, int threads = 0)
+  {
+    MappedFile file;
+    if (!file.open(filename))
+    {
+      std::cerr << "Failed to open file: " << filename << std::endl;
+      return false;
+    }
+
+    uint64_t total = ingest(file.view(), labels, P, Q, threads);
+    if (lookups)
+      *lookups = total;
+    if (total == 0)
+      std::cerr << "No lookups found in: " << filename << std::endl;
+    return true;
+  }
+};
@@ -0,0 +1,336 @@
+/**
+ * @file AdaptiveOBST.h
+ * @brief Keeps an OBST optimal while the access distribution drifts.
+ *
+ * Lookups are counted per key and per gap (see `AccessCounters`). A maintenance thread
+ * compares the expected cost of the live tree under the observed distribution with a
+ * lower bound on the optimal cost for that distribution, and rebuilds it in the
+ * background when the live tree is worse by more than a threshold.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Vector.h"
+#include "Tree.h"
+#include "OBST.h"
+#include "TreePublisher.h"
+#include "AccessCounters.h"
+
+/**
+ * @class AdaptiveOBST
+ * @brief An OBST served through a `TreePublisher` and rebuilt when its traffic changes.
+ */
+class AdaptiveOBST
+{
+private:
+  Vector<std::string> labels;
+  Vector<float> builtP, builtQ; // The distribution the live tree was built with
+  Vector<float> keyCost;        // keyCost[i] = comparisons to find key i in the live tree
+  Vector<float> gapCost;        // gapCost[k] = cost of a miss in gap k of the live tree (its dummy leaf)
+  double boundSlack;            // Optimal cost / entropy bound, measured on the distribution of the last build
+  int n;
+
+  AccessCounters counters; // Observed lookups of each key and gap
+
+  TreePublisher publisher;
+
+  double threshold;                   // Relative cost regression that triggers a rebuild
+  uint64_t minSamples;                // Lookups needed before the regression is trusted
+  std::atomic<float> priorWeight;     // Share of the old distribution kept in a rebuild
+  std::chrono::milliseconds interval; // Time between two checks of the maintenance thread
+
+  std::mutex maintenanceLock; // Serializes checks and rebuilds
+  std::thread worker;
+  std::mutex sleepLock;
+  std::condition_variable wakeUp;
+  bool stopping;
+  std::atomic<int> rebuilds;
+
+  // Fills the cost of every key and gap from the depths in the tree, with the DP's convention:
+  // a key at depth d costs d + 1, a miss ends at a dummy leaf one level below and costs d + 2
+  void computeCosts(const Tree &tree)
+  {
+    keyCost.resize(n + 1);
+    gapCost.resize(n + 1);
+    for (int i = 0; i <= n; i++)
+      keyCost[i] = gapCost[i] = 0;
+
+    struct Frame
+    {
+      const TreeNode *node;
+      int depth;
+    };
+    Vector<Frame> stack;
+    if (tree.getRoot())
+      stack.push_back({tree.getRoot(), 0});
+
+    while (stack.size() > 0)
+    {
+      Frame top = stack.back();
+      stack.pop_back();
+      const TreeNode *node = top.node;
+      int index = node->index;
+
+      keyCost[index] = float(top.depth + 1);
+      if (node->left)
+        stack.push_back({node->left, top.depth + 1});
+      else
+        gapCost[index - 1] = float(top.depth + 2);
+      if (node->right)
+        stack.push_back({node->right, top.depth + 1});
+      else
+        gapCost[index] = float(top.depth + 2);
+    }
+  }
+
+  // Expected comparisons per lookup for the given weights on the live tree
+  double expectedCost(const Vector<float> &p, const Vector<float> &q) const
+  {
+    double cost = 0, weight = 0;
+    for (int i = 1; i <= n; i++)
+    {
+      cost += p[i] * keyCost[i];
+      weight += p[i];
+    }
+    for (int k = 0; k <= n; k++)
+    {
+      cost += q[k] * gapCost[k];
+      weight += q[k];
+    }
+    return weight == 0 ? 0.0 : cost / weight;
+  }
+
+  /**
+   * @brief A lower bound on the expected cost per lookup of any tree for p and q, in O(n).
+   *
+   * With H the entropy (in bits) of the normalized p and q, Mehlhorn's bound gives
+   * H / log2(3) for the weighted path length of an optimal tree with three-way comparisons,
+   * counting keys at depth + 1 and misses at the depth of their dummy leaf. The DP also
+   * charges each dummy leaf its own level, which adds the miss share. And every lookup
+   * costs at least one comparison.
+   */
+  static double entropyBound(const Vector<float> &p, const Vector<float> &q)
+  {
+    double total = 0, misses = 0;
+    for (size_t i = 1; i < p.size(); i++)
+      total += p[i];
+    for (size_t k = 0; k < q.size(); k++)
+      misses += q[k];
+    total += misses;
+    if (total <= 0)
+      return 0;
+
+    double entropy = 0;
+    auto add = [&](double weight)
+    {
+      if (weight > 0)
+        entropy -= (weight / total) * std::log2(weight / total);
+    };
+    for (size_t i = 1; i < p.size(); i++)
+      add(p[i]);
+    for (size_t k = 0; k < q.size(); k++)
+      add(q[k]);
+
+    double bound = entropy / std::log2(3.0) + misses / total;
+    return bound < 1 ? 1 : bound;
+  }
+
+  // Measures how far above the entropy bound the live tree is for the distribution it was built for
+  void calibrateBound()
+  {
+    double bound = entropyBound(builtP, builtQ);
+    double optimal = expectedCost(builtP, builtQ); // The live tree is the DP's optimum for builtP / builtQ
+    boundSlack = (bound == 0 || optimal < bound) ? 1.0 : optimal / bound;
+  }
+
+  // See `estimateRegression` (maintenanceLock must be held)
+  double estimateRegressionLocked()
+  {
+    Vector<float> p, q;
+    if (counters.exportProbabilities(p, q) < minSamples)
+      return 0;
+
+    double reference = entropyBound(p, q) * boundSlack;
+    return reference == 0 ? 0.0 : (expectedCost(p, q) - reference) / reference;
+  }
+
+  // Builds a new tree for the observed distribution and publishes it (maintenanceLock must be held)
+  void rebuildLocked()
+  {
+    Vector<float> p, q;
+    if (counters.exportProbabilities(p, q, true) == 0)
+      return;
+
+    float priorWeight = this->priorWeight.load(std::memory_order_relaxed);
+
+    // Blend the normalized observations with the previous distribution, so keys
+    // that happened not to be looked up lately do not fall to the bottom of the tree
+    double oldTotal = 0;
+    for (int i = 1; i <= n; i++)
+      oldTotal += builtP[i];
+    for (int k = 0; k <= n; k++)
+      oldTotal += builtQ[k];
+
+    for (int i = 1; i <= n; i++)
+      p[i] = float((1 - priorWeight) * p[i] + (oldTotal > 0 ? priorWeight * builtP[i] / oldTotal : 0));
+    for (int k = 0; k <= n; k++)
+      q[k] = float((1 - priorWeight) * q[k] + (oldTotal > 0 ? priorWeight * builtQ[k] / oldTotal : 0));
+
+    Tree tree = OBST::generateTheOBST(p, q, labels);
+    computeCosts(tree);
+    builtP = p;
+    builtQ = q;
+    calibrateBound();
+    publisher.publish(std::move(tree));
+    rebuilds.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void maintenanceLoop()
+  {
+    std::unique_lock<std::mutex> lock(sleepLock);
+    while (!stopping)
+    {
+      wakeUp.wait_for(lock, interval);
+      if (stopping)
+        break;
+
+      lock.unlock();
+      checkNow();
+      lock.lock();
+    }
+  }
+
+public:
+  /**
+   * @brief Builds the initial tree from the given distribution.
+   *
+   * @param p Probabilities of successfully searching for each key (p[0] is unused).
+   * @param q Probabilities of searching for dummy keys.
+   * @param labels Names of the keys (sorted).
+   * @param threshold Relative cost regression (see `estimateRegression`) that triggers a rebuild (default: 5%).
+   * @param minSamples Lookups needed before the regression is trusted.
+   * @param interval Time between two checks of the maintenance thread.
+   * @param shards Number of shards of the access counters (see `AccessCounters`).
+   */
+  AdaptiveOBST(const Vector<float> &p, const Vector<float> &q, const Vector<std::string> &labels,
+               double threshold = 0.05, uint64_t minSamples = 10000,
+               std::chrono::milliseconds interval = std::chrono::milliseconds(1000), int shards = 1)
+      : labels(labels), builtP(p), builtQ(q), boundSlack(1), n((int)labels.size()),
+        counters((int)labels.size(), shards),
+        publisher(OBST::generateTheOBST(p, q, labels)),
+        threshold(threshold), minSamples(minSamples), priorWeight(0.05f), interval(interval),
+        stopping(false), rebuilds(0)
+  {
+    computeCosts(publisher.snapshot());
+    calibrateBound();
+  }
+
+  ~AdaptiveOBST()
+  {
+    stop();
+  }
+
+  AdaptiveOBST(const AdaptiveOBST &) = delete;
+  AdaptiveOBST &operator=(const AdaptiveOBST &) = delete;
+
+  // The publisher serving the live tree, readers register with it
+  TreePublisher &getPublisher()
+  {
+    return publisher;
+  }
+
+  /**
+   * @brief Looks a key up in the live tree and counts the access.
+   *
+   * Must be called inside a read section of `reader`. Never waits for a rebuild.
+   */
+  LookupResult find(const TreePublisher::Reader &reader, const std::string &key)
+  {
+    LookupResult result = reader.find(key);
+    counters.record(result);
+    return result;
+  }
+
+  /**
+   * @brief How much worse the live tree is than an optimal tree for the observed traffic.
+   *
+   * Running the DP on every check would cost O(n^2), so the optimum is approximated from
+   * below: (live cost - reference) / reference, with reference = `entropyBound` of the
+   * observed distribution times the ratio between the optimum and that bound measured at
+   * the last build (where the DP gives the exact optimum). The bound alone would never
+   * exceed the optimum, so the estimate errs towards rebuilding early rather than late;
+   * the measured ratio removes the bound's own slack, so a freshly built tree reads about
+   * 0 instead of triggering a rebuild on every check. It is an estimate, not a bound: when
+   * the traffic moves to a distribution where the entropy bound is much tighter or looser
+   * than it was at the last build, it is off by that difference.
+   * Returns 0 until `minSamples` lookups are counted.
+   */
+  double estimateRegression()
+  {
+    std::lock_guard<std::mutex> guard(maintenanceLock);
+    return estimateRegressionLocked();
+  }
+
+  /**
+   * @brief Rebuilds the tree now if the estimated regression crosses the threshold.
+   *
+   * The check and the rebuild run under one lock, so concurrent calls rebuild once.
+   *
+   * @return true if a new tree was published.
+   */
+  bool checkNow()
+  {
+    std::lock_guard<std::mutex> guard(maintenanceLock);
+    if (estimateRegressionLocked() <= threshold)
+      return false;
+
+    rebuildLocked();
+    return true;
+  }
+
+  // Starts the maintenance thread, which calls `checkNow` every `interval`
+  void start()
+  {
+    std::lock_guard<std::mutex> guard(sleepLock);
+    if (worker.joinable())
+      return;
+    stopping = false;
+    worker = std::thread(&AdaptiveOBST::maintenanceLoop, this);
+  }
+
+  // Stops the maintenance thread, waiting for a running rebuild to finish
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> guard(sleepLock);
+      stopping = true;
+    }
+    wakeUp.notify_all();
+    if (worker.joinable())
+      worker.join();
+  }
+
+  // Number of rebuilds done since construction
+  int getRebuildCount() const
+  {
+    return rebuilds.load(std::memory_order_relaxed);
+  }
+
+  // The counters of the lookups since the last rebuild
+  AccessCounters &getCounters()
+  {
+    return counters;
+  }
+
+  void setPriorWeight(float weight)
+  {
+    priorWeight.store(weight, std::memory_order_relaxed);
+  }
+};
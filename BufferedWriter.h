@@ -0,0 +1,172 @@
+/**
+ * @file BufferedWriter.h
+ * @brief Collects small writes into one large buffer, for the exporters and the session snapshots.
+ */
+
+#pragma once
+
+#include <ostream>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @class BufferedWriter
+ * @brief Gathers text and binary writes in a `BUFFER_BYTES` buffer and hands it to the stream when full.
+ *
+ * Writes larger than the buffer go straight to the stream. The buffer is flushed by `flush`
+ * and by the destructor. Optionally, everything written is checksummed on the way
+ * (FNV-1a, 64 bits), so a file format can store the checksum of its payload.
+ */
+class BufferedWriter
+{
+public:
+  static constexpr size_t BUFFER_BYTES = 1 << 20;
+  static constexpr uint64_t CHECKSUM_SEED = 1469598103934665603ULL;
+
+private:
+  std::ostream &out;
+  std::string buffer;
+  bool checksummed;
+  uint64_t hash;
+  uint64_t count;
+
+  void track(const char *data, size_t size)
+  {
+    count += size;
+    if (checksummed)
+      hash = checksumOf(data, size, hash);
+  }
+
+public:
+  /**
+   * @param out The stream that receives the buffer.
+   * @param checksummed Whether to checksum the bytes written (see `checksum`).
+   */
+  explicit BufferedWriter(std::ostream &out, bool checksummed = false)
+      : out(out), checksummed(checksummed), hash(CHECKSUM_SEED), count(0)
+  {
+    buffer.reserve(BUFFER_BYTES);
+  }
+
+  ~BufferedWriter()
+  {
+    flush();
+  }
+
+  BufferedWriter(const BufferedWriter &) = delete;
+  BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+  // FNV-1a of `size` bytes, continuing from `hash`
+  static uint64_t checksumOf(const char *bytes, size_t size, uint64_t hash = CHECKSUM_SEED)
+  {
+    for (size_t i = 0; i < size; i++)
+    {
+      hash ^= (unsigned char)bytes[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  void putBytes(const void *bytes, size_t size)
+  {
+    const char *data = static_cast<const char *>(bytes);
+    track(data, size);
+    if (buffer.size() + size > BUFFER_BYTES)
+      flush();
+    if (size > BUFFER_BYTES)
+      out.write(data, size);
+    else
+      buffer.append(data, size);
+  }
+
+  // Writes the bytes of a trivially copyable value, in native byte order
+  template <typename T>
+  void putValue(const T &value)
+  {
+    putBytes(&value, sizeof(T));
+  }
+
+  void put(std::string_view text)
+  {
+    putBytes(text.data(), text.size());
+  }
+
+  void put(char c)
+  {
+    track(&c, 1);
+    if (buffer.size() + 1 > BUFFER_BYTES)
+      flush();
+    buffer.push_back(c);
+  }
+
+  // Writes a number as text, in the shortest form that reads back the same
+  template <typename T>
+  void putNumber(T value)
+  {
+    char text[32];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    put(std::string_view(text, size_t(result.ptr - text)));
+  }
+
+  // Writes a quoted JSON string, escaping quotes, backslashes and control characters
+  void putJsonString(std::string_view text)
+  {
+    static const char hex[] = "0123456789abcdef";
+    put('"');
+    for (char c : text)
+    {
+      unsigned char u = static_cast<unsigned char>(c);
+      if (c == '"' || c == '\\')
+      {
+        put('\\');
+        put(c);
+      }
+      else if (u < 0x20)
+      {
+        char escaped[6] = {'\\', 'u', '0', '0', hex[u >> 4], hex[u & 15]};
+        put(std::string_view(escaped, 6));
+      }
+      else
+        put(c);
+    }
+    put('"');
+  }
+
+  // Writes text that must stay on one field of a line, escaping `\`, tabs and line breaks
+  void putTextKey(std::string_view text)
+  {
+    for (char c : text)
+    {
+      if (c == '\\')
+        put("\\\\");
+      else if (c == '\n')
+        put("\\n");
+      else if (c == '\r')
+        put("\\r");
+      else if (c == '\t')
+        put("\\t");
+      else
+        put(c);
+    }
+  }
+
+  void flush()
+  {
+    out.write(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+
+  // Bytes written so far
+  uint64_t size() const
+  {
+    return count;
+  }
+
+  // Checksum of the bytes written so far (CHECKSUM_SEED if not checksummed)
+  uint64_t checksum() const
+  {
+    return hash;
+  }
+};
@@ -13,6 +13,9 @@ private:
   Vector<float> p;
   Vector<float> q;
   Vector<std::string> labels;
+  LabelIndex labelIndex; // Position of each label, rebuilt whenever `labels` is reordered
+  // DP tables the tree was built from, kept for display, export and sessions (empty when unknown)
+  Vector<Vector<float>> e, w, root;
   std::string DOT_FILE = Settings::getDotFile();
   std::string OUTPUT_IMAGE = Settings::getOutputImage();
 
@@ -22,11 +25,25 @@ private:
   void analyzeTree();          // Option 4 in main menu
   void DisplayDerivedTables(); // Option 5 in main menu
   void DisplayEnteredData();   // Option 6 in main menu
+  void saveSession();          // Option 7 in main menu
+  void loadSession();          // Option 8 in main menu
+  void exportTree();           // Option 9 in main menu
 
   // Submenu for editing the tree
   void createTreeFromScratch();
   void addNode();
   void deleteNode();
+  void loadTreeFromFile();
+
+  // Computes the tables for the current data and builds the tree from them, or reshapes the current one
+  void buildTree(bool morph);
+  // Makes sure the tables of the current data are available
+  void ensureTables();
+
+  // Tables with more keys than this are only exported, not displayed
+  static constexpr size_t TABLE_DISPLAY_LIMIT = 12;
+  void exportTables(const Vector<Vector<float>> &e, const Vector<Vector<float>> &w, const Vector<Vector<float>> &root,
+                    bool binary);
 
 public:
   CLI()
@@ -39,4 +56,5 @@ public:
 
 #include "MainScreen.cpp"
 #include "TreeScreens.cpp"
-#include "EditTreeScreen.cpp"
\ No newline at end of file
+#include "EditTreeScreen.cpp"
+#include "SessionScreen.cpp"
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <cstdio>
+#include <limits>
 #include <string>
 #include "../Utils.h"
 
@@ -23,6 +24,20 @@ namespace CLIHELPER
     return choice;
   };
 
+  // Reads a row or column number, where -1 stands for "up to the end"
+  int getBound(std::string msg)
+  {
+    int bound;
+    std::cout << msg << std::flush;
+    while (!(std::cin >> bound) || bound < -1)
+    {
+      std::cin.clear();
+      std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+      std::cout << "Invalid input; please enter a number, or -1 for the end: " << std::flush;
+    }
+    return bound;
+  }
+
   void popAlert(std::string msg)
   {
     Utils::clearTerminal();
@@ -3,8 +3,9 @@
 #include "CLI.h"
 #include "CLIHelper.h"
 
-#include "../OBST.h"  // OBST class
-#include "../Utils.h" // Utility functions
+#include "../OBST.h"       // OBST class
+#include "../Utils.h"      // Utility functions
+#include "../DataLoader.h" // Loading labels and probabilities from files
 #include <iomanip>
 #include <algorithm>
 
@@ -17,9 +18,10 @@ void CLI::editTree()
     std::cout << "1. Create a Tree from Scratch\n";
     std::cout << "2. Add a New Node\n";
     std::cout << "3. Delete a Node\n";
+    std::cout << "4. Load a Tree from a File\n";
     std::cout << "0. Back to Main Menu\n";
 
-    int choice = CLIHELPER::getChoice(3, "USE_DEFAULT");
+    int choice = CLIHELPER::getChoice(4, "USE_DEFAULT");
 
     switch (choice)
     {
@@ -32,6 +34,9 @@ void CLI::editTree()
     case 3:
       deleteNode();
       break;
+    case 4:
+      loadTreeFromFile();
+      break;
     case 0:
       return; // Go back to the main menu
     default:
@@ -53,7 +58,38 @@ void CLI::createTreeFromScratch()
   }
 
   useQ = Utils::getDataFromUser(labels, n, p, q);
-  tree.assign(OBST::generateTheOBST(p, q, labels, false));
+  labelIndex.rebuild(labels);
+  buildTree(false);
+}
+
+void CLI::loadTreeFromFile()
+{
+  Utils::clearTerminal();
+  std::cout << "\n===== Load Tree from File =====\n";
+  std::cout << "Rows are 'label,p' or 'label,p,q', and '#q0,value' sets q0.\n\n";
+
+  std::string filename;
+  std::cout << "Enter the path of the file: " << std::flush;
+  std::cin >> filename;
+
+  Vector<std::string> newLabels;
+  Vector<float> newP, newQ;
+  bool newUseQ = false;
+  if (!DataLoader::loadFile(filename, newLabels, newP, newQ, newUseQ))
+  {
+    CLIHELPER::popAlert("Could not load the file, the tree is unchanged.");
+    return;
+  }
+
+  labels = newLabels;
+  p = newP;
+  q = newQ;
+  useQ = newUseQ;
+  n = labels.size();
+  labelIndex.rebuild(labels);
+  buildTree(false);
+
+  CLIHELPER::popAlert("Loaded " + std::to_string(n) + " nodes successfully!");
 }
 
 void CLI::addNode()
@@ -67,7 +103,7 @@ void CLI::addNode()
     return;
   }
 
-  std::string newNodeLabel = Utils::readLabel(labels, "Enter the label for the new node: ");
+  std::string newNodeLabel = Utils::readLabel(labelIndex, "Enter the label for the new node: ");
   float newNodeP = Utils::readFloatInput("Enter the probability of successful search (p): ", false);
 
   if (tree.isEmpty())
@@ -97,8 +133,9 @@ void CLI::addNode()
   }
 
   Utils::sortInputs(labels, p);
+  labelIndex.rebuild(labels);
 
-  tree.assign(OBST::generateTheOBST(p, q, labels, false));
+  buildTree(true); // Reshape the current tree instead of rebuilding it
 
   CLIHELPER::popAlert("Node added successfully!");
 }
@@ -140,9 +177,9 @@ void CLI::deleteNode()
               << std::setw(15) << probQ << "\n";
   }
 
-  std::string nodeToDelete = Utils::readLabel(labels, "\nEnter the label of the node to delete: ", true);
+  std::string nodeToDelete = Utils::readLabel(labelIndex, "\nEnter the label of the node to delete: ", true);
 
-  int index = labels.findOne(nodeToDelete);
+  int index = labelIndex.find(nodeToDelete);
   if (index == -1)
   {
     CLIHELPER::popAlert("The node does not exist in the tree!");
@@ -152,8 +189,26 @@ void CLI::deleteNode()
   labels.removeByIndex(index);
   p.removeByIndex(index + 1);
   q.removeByIndex(index + 1);
+  labelIndex.rebuild(labels);
 
-  tree.assign(OBST::generateTheOBST(p, q, labels, false));
+  buildTree(true); // Reshape the current tree instead of rebuilding it
 
   CLIHELPER::popAlert("Node deleted successfully!");
 }
+
+void CLI::buildTree(bool morph)
+{
+  if (morph)
+  {
+    OBST::computeTables(p, q, e, w, root);
+    OBST::morphTree(tree, root, labels, p, q);
+  }
+  else
+    tree.assign(OBST::generateTheOBST(p, q, labels, e, w, root));
+}
+
+void CLI::ensureTables()
+{
+  if (e.size() == 0)
+    OBST::computeTables(p, q, e, w, root);
+}
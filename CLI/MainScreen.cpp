@@ -15,9 +15,12 @@ void CLI::show()
     std::cout << "4. Analyze Tree\n";
     std::cout << "5. Display Derived Tables\n";
     std::cout << "6. Display Entered Data\n";
+    std::cout << "7. Save Session\n";
+    std::cout << "8. Load Session\n";
+    std::cout << "9. Export Tree\n";
     std::cout << "0. Exit\n";
 
-    int choice = CLIHELPER::getChoice(6, "USE_DEFAULT");
+    int choice = CLIHELPER::getChoice(9, "USE_DEFAULT");
 
     switch (choice)
     {
@@ -39,6 +42,15 @@ void CLI::show()
     case 6:
       DisplayEnteredData();
       break;
+    case 7:
+      saveSession();
+      break;
+    case 8:
+      loadSession();
+      break;
+    case 9:
+      exportTree();
+      break;
     case 0:
       Utils::clearTerminal();
       std::cout << "Exiting... As-Salamu Alaykum!\n";
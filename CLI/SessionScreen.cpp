@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CLI.h"
+#include "CLIHelper.h"
+
+#include "../OBST.h"            // OBST class
+#include "../Utils.h"           // Utility functions
+#include "../SessionSnapshot.h" // Saving and restoring sessions
+
+void CLI::saveSession()
+{
+  Utils::clearTerminal();
+  std::cout << "\n===== Save Session =====\n";
+
+  if (tree.isEmpty())
+  {
+    CLIHELPER::popAlert("The tree is empty! Please create a tree first.");
+    return;
+  }
+
+  std::string filename;
+  std::cout << "Enter the path of the session file: " << std::flush;
+  std::cin >> filename;
+
+  std::string choice;
+  std::cout << "Do you want to include the derived tables (faster restore, bigger file)? ('y' to 'yes'): ";
+  std::cin >> choice;
+
+  Session session;
+  session.labels = labels;
+  session.p = p;
+  session.q = q;
+  session.useQ = useQ;
+  session.tree = tree;
+  if (choice == "y")
+  {
+    ensureTables(); // The tables of the last build, computed only if the session was loaded without them
+    session.e = e;
+    session.w = w;
+    session.root = root;
+    session.hasTables = true;
+  }
+
+  if (!SessionSnapshot::save(filename, session))
+  {
+    CLIHELPER::popAlert("Could not save the session.");
+    return;
+  }
+
+  CLIHELPER::popAlert("Session saved successfully!");
+}
+
+void CLI::loadSession()
+{
+  Utils::clearTerminal();
+  std::cout << "\n===== Load Session =====\n";
+
+  std::string filename;
+  std::cout << "Enter the path of the session file: " << std::flush;
+  std::cin >> filename;
+
+  Session session;
+  if (!SessionSnapshot::load(filename, session))
+  {
+    CLIHELPER::popAlert("Could not load the session, the current one is unchanged.");
+    return;
+  }
+
+  labels = session.labels;
+  labelIndex.rebuild(labels);
+  p = session.p;
+  q = session.q;
+  useQ = session.useQ;
+  n = labels.size();
+  tree.assign(session.tree);
+
+  // Tables saved with the session are kept, otherwise they are computed when first needed
+  e = std::move(session.e);
+  w = std::move(session.w);
+  root = std::move(session.root);
+
+  CLIHELPER::popAlert("Session loaded successfully!");
+}
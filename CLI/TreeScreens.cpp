@@ -6,6 +6,8 @@
 #include "../Utils.h" // Utility functions
 #include "../TreeVisualization.h"
 #include "../OBST.h" // OBST class
+#include "../TableExport.h" // Exporting the derived tables
+#include "../TreeExport.h"  // Exporting the tree
 #include <iomanip>
 #include <algorithm>
 
@@ -52,6 +54,42 @@ void CLI::visualizeTree()
   TreeVisualization::visualizeTree(tree, DOT_FILE, OUTPUT_IMAGE, true);
 }
 
+void CLI::exportTree()
+{
+  Utils::clearTerminal();
+  std::cout << "\n===== Export Tree =====\n";
+
+  if (tree.isEmpty())
+  {
+    CLIHELPER::popAlert("The tree is empty! Please create a tree first.");
+    return;
+  }
+
+  std::cout << "1. Nested JSON\n";
+  std::cout << "2. Flat JSON (node list with child indices)\n";
+  std::cout << "3. Compact preorder text\n";
+  std::cout << "0. Back to main menu\n";
+
+  int choice = CLIHELPER::getChoice(3, "USE_DEFAULT");
+  if (choice == 0)
+    return;
+
+  std::string filename;
+  std::cout << "Enter the path of the output file: " << std::flush;
+  std::cin >> filename;
+
+  TreeExport::Format format = (choice == 1)   ? TreeExport::NESTED_JSON
+                              : (choice == 2) ? TreeExport::FLAT_JSON
+                                              : TreeExport::PREORDER_TEXT;
+  if (!TreeExport::writeFile(tree, filename, format))
+  {
+    CLIHELPER::popAlert("Could not export the tree.");
+    return;
+  }
+
+  CLIHELPER::popAlert("Tree exported successfully!");
+}
+
 void CLI::analyzeTree()
 {
   if (tree.isEmpty())
@@ -87,25 +125,63 @@ void CLI::DisplayDerivedTables()
     return;
   }
 
+  ensureTables();
+
   while (true)
   {
     Utils::clearTerminal();
     std::cout << "\n===== Display Derived Tables =====\n";
 
-    OBST::generateTheOBST(p, q, labels, true);
+    // Big tables flood the terminal, they are only worth exporting
+    if (labels.size() <= TABLE_DISPLAY_LIMIT)
+      OBST::displayTables(e, w, root);
+    else
+      std::cout << "The tables are too large to display (" << labels.size() << " keys), export them instead.\n";
 
-    int choice = CLIHELPER::getChoice(0, "\nPress [0] to back to main menu\n");
+    std::cout << "\n1. Export the tables as CSV\n";
+    std::cout << "2. Export the tables as binary\n";
+    std::cout << "0. Back to main menu\n";
+
+    int choice = CLIHELPER::getChoice(2, "USE_DEFAULT");
 
     switch (choice)
     {
     case 0:
       return; // Go back to the main menu
+    case 1:
+    case 2:
+      exportTables(e, w, root, choice == 2);
+      break;
     default:
       std::cout << "Invalid choice. (from default of while)\n";
     }
   }
 }
 
+void CLI::exportTables(const Vector<Vector<float>> &e, const Vector<Vector<float>> &w, const Vector<Vector<float>> &root,
+                       bool binary)
+{
+  std::string filename;
+  std::cout << "Enter the path of the output file: " << std::flush;
+  std::cin >> filename;
+
+  TableExport::Window window;
+  std::string choice;
+  std::cout << "Do you want to export only some rows and columns? ('y' to 'yes'): ";
+  std::cin >> choice;
+  if (choice == "y")
+  {
+    window.firstRow = (int)Utils::readFloatInput("First row: ", true);
+    window.lastRow = CLIHELPER::getBound("Last row (-1 for the last one): ");
+    window.firstColumn = (int)Utils::readFloatInput("First column: ", true);
+    window.lastColumn = CLIHELPER::getBound("Last column (-1 for the last one): ");
+  }
+
+  bool exported = binary ? TableExport::writeBinary(filename, e, w, root, window)
+                         : TableExport::writeCsv(filename, e, w, root, window);
+  CLIHELPER::popAlert(exported ? "Tables exported successfully!" : "Could not export the tables.");
+}
+
 void CLI::DisplayEnteredData()
 {
   if (tree.isEmpty())
@@ -0,0 +1,258 @@
+/**
+ * @file ConstexprOBST.h
+ * @brief Builds an Optimal Binary Search Tree at compile time for key sets known in advance.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+/**
+ * @class ConstexprOBST
+ * @brief An OBST of N fixed labels, laid out in a flat array and usable in constant expressions.
+ *
+ * The DP is the same as `OBST::computeOBST` (Knuth's bounds, same tie-breaking), but on
+ * fixed-size `std::array` tables and integer weights, so it runs during constant evaluation.
+ * The nodes are stored in breadth-first (Eytzinger) order, root first, with explicit child
+ * positions since an OBST is rarely complete. Declared `constexpr`, the array is baked into
+ * the binary and costs nothing at startup:
+ *
+ * @code
+ * constexpr std::array<std::string_view, 3> labels = {"GET", "POST", "PUT"};
+ * constexpr auto tree = ConstexprOBST<3>::build(labels, {0, 70, 20, 10}, {0, 0, 0, 0});
+ * static_assert(tree.find("POST").index == 2);
+ * @endcode
+ *
+ * @tparam N Number of keys.
+ */
+template <std::size_t N>
+class ConstexprOBST
+{
+  static_assert(N >= 1, "ConstexprOBST needs at least one key");
+
+public:
+  /**
+   * @struct Node
+   * A key and the positions of its children in the node array (-1 for none).
+   */
+  struct Node
+  {
+    std::string_view key{};
+    int index = 0; // 1-based position of the key among the labels
+    int left = -1;
+    int right = -1;
+  };
+
+  /**
+   * @struct Result
+   * The key index found (0 if missing) and, on a miss, the index in q of its gap.
+   */
+  struct Result
+  {
+    int index = 0;
+    int gap = -1;
+  };
+
+  /**
+   * @brief Same ordering as `Utils::compareStrings`: numeric labels by value, anything else lexicographically.
+   */
+  static constexpr int compareLabels(std::string_view a, std::string_view b)
+  {
+    if (isNumeric(a) && isNumeric(b))
+    {
+      // Drop leading zeros (keeping one digit), then the longer number is the bigger one
+      while (a.size() > 1 && a[0] == '0')
+        a.remove_prefix(1);
+      while (b.size() > 1 && b[0] == '0')
+        b.remove_prefix(1);
+      if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+    }
+
+    int result = a.compare(b);
+    return (result < 0) ? -1 : (result > 0) ? 1 : 0;
+  }
+
+  /**
+   * @brief Converts a probability to the fixed-point integer weights `build` takes.
+   *
+   * @param probability A probability in [0, 1].
+   * @param scale The weight of probability 1 (default: 2^16).
+   */
+  static constexpr uint64_t toFixed(double probability, uint64_t scale = uint64_t(1) << 16)
+  {
+    return uint64_t(probability * double(scale) + 0.5);
+  }
+
+  /**
+   * @brief Runs the DP and lays the optimal tree out in breadth-first order.
+   *
+   * The tables take 3 * (N + 2)^2 integers, so evaluate this in a `constexpr` context
+   * rather than at run time for large N.
+   *
+   * @param labels Names of the keys, sorted with `compareLabels`.
+   * @param p Weights of successfully searching for each key (p[0] is unused).
+   * @param q Weights of searching for dummy keys.
+   * @throws std::invalid_argument If the labels are not sorted (a compile error in a constant expression).
+   */
+  static constexpr ConstexprOBST build(const std::array<std::string_view, N> &labels,
+                                       const std::array<uint64_t, N + 1> &p, const std::array<uint64_t, N + 1> &q)
+  {
+    for (std::size_t a = 1; a < N; a++)
+      if (compareLabels(labels[a - 1], labels[a]) >= 0)
+        throw std::invalid_argument("Labels must be sorted and unique in ConstexprOBST::build");
+
+    Table E{}, W{}, Root{};
+    computeTables(p, q, E, W, Root);
+
+    ConstexprOBST tree;
+    tree.cost = E[1][N];
+    tree.weight = W[1][N];
+
+    // Breadth-first layout: ranges wait in a queue, and a node's children get the next free positions
+    std::array<Range, N> queue{};
+    std::size_t head = 0, tail = 0;
+    queue[tail++] = {1, int(N), -1, false};
+
+    while (head < tail)
+    {
+      Range range = queue[head];
+      int position = int(head++);
+      int r = int(Root[range.i][range.j]);
+
+      tree.nodes[position].key = labels[r - 1]; // Labels are 0-indexed
+      tree.nodes[position].index = r;
+      if (range.parent >= 0)
+      {
+        if (range.isLeft)
+          tree.nodes[range.parent].left = position;
+        else
+          tree.nodes[range.parent].right = position;
+      }
+
+      if (range.i <= r - 1)
+        queue[tail++] = {range.i, r - 1, position, true};
+      if (r + 1 <= range.j)
+        queue[tail++] = {r + 1, range.j, position, false};
+    }
+
+    return tree;
+  }
+
+  /**
+   * @brief Searches for a key, walking the node array from the root.
+   */
+  constexpr Result find(std::string_view key) const
+  {
+    Result result;
+    int position = 0;
+    while (true)
+    {
+      const Node &node = nodes[position];
+      int cmp = compareLabels(key, node.key);
+      if (cmp == 0)
+      {
+        result.index = node.index;
+        return result;
+      }
+
+      int next = (cmp < 0) ? node.left : node.right;
+      if (next < 0)
+      {
+        result.gap = (cmp < 0) ? node.index - 1 : node.index;
+        return result;
+      }
+      position = next;
+    }
+  }
+
+  // The nodes in breadth-first order, getNodes()[0] is the root
+  constexpr const std::array<Node, N> &getNodes() const
+  {
+    return nodes;
+  }
+
+  constexpr std::size_t size() const
+  {
+    return N;
+  }
+
+  // E[1][N] of the DP: the expected search cost times the total weight
+  constexpr uint64_t getCost() const
+  {
+    return cost;
+  }
+
+  // W[1][N] of the DP: the sum of all p and q
+  constexpr uint64_t getWeight() const
+  {
+    return weight;
+  }
+
+  constexpr ConstexprOBST() : nodes{}, cost(0), weight(0) {}
+
+private:
+  using Table = std::array<std::array<uint64_t, N + 2>, N + 2>;
+
+  // A range [i, j] waiting for its place in the array, and where to link it from
+  struct Range
+  {
+    int i = 0, j = 0;
+    int parent = -1;
+    bool isLeft = false;
+  };
+
+  std::array<Node, N> nodes;
+  uint64_t cost;
+  uint64_t weight;
+
+  static constexpr bool isNumeric(std::string_view s)
+  {
+    for (char c : s)
+      if (c < '0' || c > '9')
+        return false;
+    return !s.empty();
+  }
+
+  // The loops of `OBST::initializeLoop` and `OBST::computeOBST` on integer weights
+  static constexpr void computeTables(const std::array<uint64_t, N + 1> &P, const std::array<uint64_t, N + 1> &Q,
+                                      Table &E, Table &W, Table &Root)
+  {
+    for (std::size_t a = 1; a <= N; a++)
+    {
+      // Base case for subtrees with no keys
+      W[a][a - 1] = E[a][a - 1] = Q[a - 1];
+
+      // Base case for subtrees with one key: root is the key itself
+      Root[a][a] = a;
+      W[a][a] = Q[a - 1] + P[a] + Q[a];
+      E[a][a] = Q[a - 1] + Q[a] + W[a][a];
+    }
+    W[N + 1][N] = E[N + 1][N] = Q[N];
+
+    for (std::size_t l = 2; l <= N; l++) // l is the length of the subtree
+    {
+      for (std::size_t i = 1; i <= N - l + 1; i++)
+      {
+        std::size_t j = i + l - 1;
+        E[i][j] = UINT64_MAX;
+        W[i][j] = W[i][j - 1] + P[j] + Q[j];
+
+        // Test each possible root from `root[i][j-1]` to `root[i+1][j]`
+        for (std::size_t r = Root[i][j - 1]; r <= Root[i + 1][j]; r++)
+        {
+          uint64_t currCost = E[i][r - 1] + E[r + 1][j] + W[i][j];
+          if (currCost < E[i][j])
+          {
+            E[i][j] = currCost;
+            Root[i][j] = r;
+          }
+        }
+      }
+    }
+  }
+};
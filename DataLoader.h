@@ -0,0 +1,313 @@
+/**
+ * @file DataLoader.h
+ * @brief Loads labels and probabilities from CSV/TSV files, for key sets too big to type in.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "Vector.h"
+#include "Utils.h"
+#include "TaskPool.h"
+#include "MappedFile.h"
+
+/**
+ * @class DataLoader
+ * @brief Parses `label,p[,q]` rows into the labels, P and Q that `OBST::generateTheOBST` takes.
+ *
+ * File format, one key per line:
+ * - `label,p` or `label,p,q` (tabs work as separators too), where q is the probability of
+ *   searching between this label and the next one, so row i gives P[i] and Q[i].
+ * - `#q0,value` sets Q[0], the probability of searching below the first label.
+ * - Other lines starting with `#`, and blank lines, are skipped. So is a first line
+ *   whose p is not a number (a header).
+ *
+ * Rows without q leave it at 0. If any q is given, the rows must already be sorted
+ * (q depends on the order); otherwise unsorted rows are sorted with `Utils::sortInputs`.
+ * Large inputs are split at line boundaries and parsed in parallel.
+ */
+class DataLoader
+{
+public:
+  // Inputs smaller than this are parsed by the calling thread alone
+  static constexpr size_t PARALLEL_PARSE_BYTES = 1 << 20;
+
+private:
+  // What one chunk of the input parsed into
+  struct Chunk
+  {
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    Vector<std::string> labels;
+    Vector<float> p, q;
+    bool hasQ = false;
+    bool hasQ0 = false;
+    float q0 = 0;
+    size_t lines = 0;     // Lines in the chunk
+    size_t errorLine = 0; // Line (1-based, within the chunk) of the first error, 0 if none
+    std::string error;
+  };
+
+  static std::string_view trim(std::string_view s)
+  {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\r'))
+      s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r'))
+      s.remove_suffix(1);
+    return s;
+  }
+
+  // Cuts the next field off `line` at the first ',' or tab
+  static std::string_view nextField(std::string_view &line)
+  {
+    size_t cut = line.find_first_of(",\t");
+    std::string_view field = line.substr(0, cut);
+    line = (cut == std::string_view::npos) ? std::string_view() : line.substr(cut + 1);
+    return trim(field);
+  }
+
+  // Parses a whole field as a non-negative probability
+  static bool parseProbability(std::string_view field, float &value)
+  {
+    if (field.empty())
+      return false;
+    if (field.front() == '+')
+      field.remove_prefix(1);
+    auto parsed = std::from_chars(field.data(), field.data() + field.size(), value);
+    return parsed.ec == std::errc() && parsed.ptr == field.data() + field.size() && value >= 0;
+  }
+
+  static void parseChunk(Chunk &chunk, bool firstChunk)
+  {
+    const char *cursor = chunk.begin;
+    while (cursor < chunk.end)
+    {
+      const char *newline = static_cast<const char *>(std::memchr(cursor, '\n', size_t(chunk.end - cursor)));
+      const char *lineEnd = newline ? newline : chunk.end;
+      std::string_view line = trim(std::string_view(cursor, size_t(lineEnd - cursor)));
+      cursor = newline ? newline + 1 : chunk.end;
+      chunk.lines++;
+
+      if (line.empty())
+        continue;
+
+      if (line.front() == '#')
+      {
+        std::string_view directive = line;
+        if (nextField(directive) == "#q0")
+        {
+          if (!parseProbability(nextField(directive), chunk.q0))
+          {
+            chunk.errorLine = chunk.lines;
+            chunk.error = "Invalid q0 value";
+            return;
+          }
+          chunk.hasQ0 = true;
+        }
+        continue;
+      }
+
+      std::string_view rest = line;
+      std::string_view label = nextField(rest);
+      std::string_view pField = nextField(rest);
+      std::string_view qField = nextField(rest);
+
+      float p = 0, q = 0;
+      if (!parseProbability(pField, p))
+      {
+        // A first line without a number is a header
+        if (firstChunk && chunk.lines == 1)
+          continue;
+        chunk.errorLine = chunk.lines;
+        chunk.error = "Invalid probability (p)";
+        return;
+      }
+      if (label.empty())
+      {
+        chunk.errorLine = chunk.lines;
+        chunk.error = "Empty label";
+        return;
+      }
+      if (!qField.empty())
+      {
+        if (!parseProbability(qField, q))
+        {
+          chunk.errorLine = chunk.lines;
+          chunk.error = "Invalid probability (q)";
+          return;
+        }
+        chunk.hasQ = true;
+      }
+
+      chunk.labels.push_back(std::string(label));
+      chunk.p.push_back(p);
+      chunk.q.push_back(q);
+    }
+  }
+
+public:
+  /**
+   * @brief Splits text into `parts` pieces of about the same size, each ending at a line end.
+   *
+   * Every line is in exactly one piece; pieces may be empty when lines are long.
+   */
+  static Vector<std::string_view> splitAtLines(std::string_view text, size_t parts)
+  {
+    if (parts == 0)
+      parts = 1;
+
+    Vector<std::string_view> result(parts);
+    const char *start = text.data();
+    const char *end = text.data() + text.size();
+    for (size_t c = 0; c < parts; c++)
+    {
+      const char *cut = (c + 1 == parts) ? end : text.data() + text.size() / parts * (c + 1);
+      if (cut < start)
+        cut = start;
+      if (cut < end)
+      {
+        const char *newline = static_cast<const char *>(std::memchr(cut, '\n', size_t(end - cut)));
+        cut = newline ? newline + 1 : end;
+      }
+      result[c] = std::string_view(start, size_t(cut - start));
+      start = cut;
+    }
+    return result;
+  }
+
+  /**
+   * @brief Parses the rows in `text` into labels, P and Q.
+   *
+   * @param text The contents of a file in the format above.
+   * @param labels Output names of the keys (n entries, sorted).
+   * @param P Output probabilities of successful search (n + 1 entries, P[0] = 0).
+   * @param Q Output probabilities of un-successful search (n + 1 entries).
+   * @param hasQ Set to whether the input gave any q.
+   * @param threads Number of chunks to parse in parallel (0: one per worker of the shared pool).
+   * @return true on success; on failure the outputs are left empty and the error is printed.
+   */
+  static bool parse(std::string_view text, Vector<std::string> &labels, Vector<float> &P, Vector<float> &Q,
+                    bool &hasQ, int threads = 0)
+  {
+    labels = Vector<std::string>();
+    P = Vector<float>(1);
+    Q = Vector<float>(1);
+    P[0] = Q[0] = 0;
+    hasQ = false;
+
+    TaskPool &pool = TaskPool::shared();
+    size_t chunkCount = 1;
+    if (text.size() >= PARALLEL_PARSE_BYTES)
+      chunkCount = (threads > 0) ? size_t(threads) : size_t(pool.size()) + 1;
+
+    Vector<std::string_view> parts = splitAtLines(text, chunkCount);
+    Vector<Chunk> chunks(chunkCount);
+    for (size_t c = 0; c < chunkCount; c++)
+    {
+      chunks[c].begin = parts[c].data();
+      chunks[c].end = parts[c].data() + parts[c].size();
+    }
+
+    if (chunkCount == 1)
+    {
+      parseChunk(chunks[0], true);
+    }
+    else
+    {
+      TaskGroup group(pool);
+      for (size_t c = 0; c < chunkCount; c++)
+      {
+        Chunk *chunk = &chunks[c];
+        bool first = (c == 0);
+        group.run([chunk, first]
+                  { parseChunk(*chunk, first); });
+      }
+      group.wait();
+    }
+
+    // Report the first error in file order
+    size_t lineOffset = 0, total = 0;
+    for (size_t c = 0; c < chunkCount; c++)
+    {
+      if (chunks[c].errorLine)
+      {
+        std::cerr << chunks[c].error << " on line " << lineOffset + chunks[c].errorLine << std::endl;
+        return false;
+      }
+      lineOffset += chunks[c].lines;
+      total += chunks[c].labels.size();
+      hasQ = hasQ || chunks[c].hasQ || chunks[c].hasQ0;
+    }
+
+    // Stitch the chunks together in the layout generateTheOBST expects
+    labels.resize(total);
+    P.resize(total + 1);
+    Q.resize(total + 1);
+    size_t k = 0;
+    for (size_t c = 0; c < chunkCount; c++)
+    {
+      Chunk &chunk = chunks[c];
+      if (chunk.hasQ0)
+        Q[0] = chunk.q0;
+      for (size_t i = 0; i < chunk.labels.size(); i++, k++)
+      {
+        labels[k] = std::move(chunk.labels[i]);
+        P[k + 1] = chunk.p[i];
+        Q[k + 1] = chunk.q[i];
+      }
+    }
+
+    // The labels must be sorted and unique; without q they can be sorted here
+    bool sorted = true;
+    for (size_t i = 1; i < total && sorted; i++)
+      sorted = Utils::compareStrings(labels[i - 1], labels[i]) < 0;
+
+    if (!sorted)
+    {
+      if (hasQ)
+      {
+        std::cerr << "The rows must be sorted by label, without duplicates, when q is given" << std::endl;
+        labels = Vector<std::string>();
+        P.resize(1);
+        Q.resize(1);
+        return false;
+      }
+
+      Utils::sortInputs(labels, P);
+      for (size_t i = 1; i < total; i++)
+      {
+        if (Utils::compareStrings(labels[i - 1], labels[i]) == 0)
+        {
+          std::cerr << "Duplicated label: " << labels[i] << std::endl;
+          labels = Vector<std::string>();
+          P.resize(1);
+          Q.resize(1);
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Loads a file in the format above (see `parse`).
+   *
+   * @return true on success; on failure the error is printed.
+   */
+  static bool loadFile(const std::string &filename, Vector<std::string> &labels, Vector<float> &P, Vector<float> &Q,
+                       bool &hasQ, int threads = 0)
+  {
+    MappedFile file;
+    if (!file.open(filename))
+    {
+      std::cerr << "Failed to open file: " << filename << std::endl;
+      return false;
+    }
+    return parse(file.view(), labels, P, Q, hasQ, threads);
+  }
+};
@@ -0,0 +1,78 @@
+/**
+ * @file FileReplace.h
+ * @brief Replaces a file with a fully written new version, so a crash never leaves a partial file behind.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define OBST_HAVE_FSYNC 1
+#endif
+
+/**
+ * @class FileReplace
+ * @brief Write to `temporaryFor(filename)`, then `commit` it over `filename`.
+ *
+ * The temporary file lives next to the target (same directory, so the rename stays on one
+ * file system). `commit` makes its contents durable, renames it over the target and makes
+ * the rename durable, so the target holds either the old or the new contents.
+ */
+class FileReplace
+{
+private:
+#ifdef OBST_HAVE_FSYNC
+  static void syncPath(const std::string &path)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+      fsync(fd);
+      ::close(fd);
+    }
+  }
+#endif
+
+public:
+  // A temporary name next to `filename`, unique to this process
+  static std::string temporaryFor(const std::string &filename)
+  {
+    std::string temporary = filename + ".tmp";
+#ifdef OBST_HAVE_FSYNC
+    temporary += "." + std::to_string(getpid());
+#endif
+    return temporary;
+  }
+
+  /**
+   * @brief Moves the finished `temporary` over `filename`.
+   *
+   * @return true on success; on failure the temporary file is removed and `filename` is unchanged.
+   */
+  static bool commit(const std::string &temporary, const std::string &filename)
+  {
+#ifdef OBST_HAVE_FSYNC
+    // Make the contents durable before they become visible
+    syncPath(temporary);
+#else
+    std::remove(filename.c_str()); // rename does not replace files here, so this step is not atomic
+#endif
+
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0)
+    {
+      std::remove(temporary.c_str());
+      return false;
+    }
+
+#ifdef OBST_HAVE_FSYNC
+    // Make the rename itself durable, it lives in the directory
+    size_t slash = filename.find_last_of('/');
+    syncPath((slash == std::string::npos) ? "." : (slash == 0) ? "/" : filename.substr(0, slash));
+#endif
+    return true;
+  }
+};
@@ -0,0 +1,417 @@
+/**
+ * @file FrequencySketch.h
+ * @brief Estimates p and q from a stream of lookups in bounded memory, favoring recent traffic.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Vector.h"
+#include "Tree.h"
+#include "Utils.h"
+
+/**
+ * @struct SketchReport
+ * How much the estimates of a `FrequencySketch` can be trusted.
+ *
+ * Every estimated count is at least the true (decayed) count, and with probability
+ * at least 1 - delta it exceeds it by at most epsilon * lookups, i.e. an error of at
+ * most epsilon on each p and q given by `exportProbabilities`.
+ */
+struct SketchReport
+{
+  double lookups = 0;    // Decayed number of lookups seen
+  double epsilon = 0;    // e / width
+  double delta = 0;      // e^-depth
+  double errorBound = 0; // epsilon * lookups, the bound on the error of each count
+};
+
+/**
+ * @struct HeavyHitter
+ * A key or gap among the most looked-up ones, with its estimated (decayed) count.
+ */
+struct HeavyHitter
+{
+  int index = 0;      // Key index (1..n), or gap index (0..n) if `isGap`
+  bool isGap = false;
+  double count = 0;
+};
+
+/**
+ * @class FrequencySketch
+ * @brief A count-min sketch of key hits and gap misses, with a heavy-hitter list and exponential decay.
+ *
+ * Hits of key i and misses in gap k are counted as items of the same sketch (depth rows of
+ * width counters), so memory is depth * width + heavyCount entries whatever the number of keys.
+ * Decay is lazy: instead of scaling every counter, the weight of new lookups grows, and the
+ * counters are only rescaled once in a while to stay in range.
+ *
+ * Not thread-safe: use one sketch per thread and `merge` them, or guard it with a lock.
+ */
+class FrequencySketch
+{
+private:
+  Vector<std::string> labels;
+  int n;
+
+  size_t width; // Counters per row, a power of two
+  int depth;    // Number of rows (independent hashes)
+  Vector<double> counters;
+  Vector<uint64_t> seeds;
+
+  double increment; // Weight of one lookup now, grows as older lookups decay
+  double lookups;   // Sum of the weights of all lookups (in the same scaled units)
+  double halfLife;  // Seconds for a lookup to lose half its weight in `elapse`, 0 for no decay
+
+  size_t heavyCount; // Size of the heavy-hitter list
+  Vector<HeavyHitter> heavy;
+  std::unordered_map<uint64_t, int> heavySlot; // Item -> position in `heavy`
+  int minSlot;                                 // Position of the smallest count in `heavy`
+
+  // Items: hits of key i are i (1..n), misses in gap k are n + 1 + k
+  uint64_t hitItem(int index) const
+  {
+    return uint64_t(index);
+  }
+
+  uint64_t missItem(int gap) const
+  {
+    return uint64_t(n) + 1 + uint64_t(gap);
+  }
+
+  // splitmix64 finalizer, one seed per row gives independent hashes
+  static uint64_t mix(uint64_t x)
+  {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  double &counter(int row, uint64_t item) const
+  {
+    return counters[size_t(row) * width + (mix(item ^ seeds[row]) & (width - 1))];
+  }
+
+  // Smallest counter of the item over all rows (scaled units)
+  double estimateScaled(uint64_t item) const
+  {
+    double smallest = counter(0, item);
+    for (int row = 1; row < depth; row++)
+    {
+      double value = counter(row, item);
+      if (value < smallest)
+        smallest = value;
+    }
+    return smallest;
+  }
+
+  void findMinSlot()
+  {
+    minSlot = 0;
+    for (size_t i = 1; i < heavy.size(); i++)
+      if (heavy[i].count < heavy[minSlot].count)
+        minSlot = int(i);
+  }
+
+  // Keeps the item in the heavy-hitter list if it is now among the largest (Space-Saving style)
+  void updateHeavy(uint64_t item, double estimate)
+  {
+    if (heavyCount == 0)
+      return;
+
+    auto found = heavySlot.find(item);
+    if (found != heavySlot.end())
+    {
+      heavy[found->second].count = estimate;
+      if (found->second == minSlot)
+        findMinSlot();
+      return;
+    }
+
+    HeavyHitter entry;
+    entry.isGap = item > uint64_t(n);
+    entry.index = entry.isGap ? int(item - uint64_t(n) - 1) : int(item);
+    entry.count = estimate;
+
+    if (heavy.size() < heavyCount)
+    {
+      heavySlot[item] = int(heavy.size());
+      heavy.push_back(entry);
+      findMinSlot();
+    }
+    else if (estimate > heavy[minSlot].count)
+    {
+      HeavyHitter &old = heavy[minSlot];
+      heavySlot.erase(old.isGap ? missItem(old.index) : hitItem(old.index));
+      heavySlot[item] = minSlot;
+      old = entry;
+      findMinSlot();
+    }
+  }
+
+  void add(uint64_t item)
+  {
+    for (int row = 0; row < depth; row++)
+      counter(row, item) += increment;
+    lookups += increment;
+    updateHeavy(item, estimateScaled(item));
+  }
+
+  // Brings the weights back to 1, so the scaled counters do not overflow
+  void rescale()
+  {
+    double factor = 1.0 / increment;
+    for (size_t i = 0; i < counters.size(); i++)
+      counters[i] *= factor;
+    for (size_t i = 0; i < heavy.size(); i++)
+      heavy[i].count *= factor;
+    lookups *= factor;
+    increment = 1;
+  }
+
+public:
+  /**
+   * @param labels Names of the keys (sorted), used to place raw keys in `recordKey`.
+   * @param width Counters per row, rounded up to a power of two (error epsilon = e / width).
+   * @param depth Number of rows (failure probability delta = e^-depth).
+   * @param heavyCount Number of heavy hitters tracked.
+   * @param halfLifeSeconds Half-life used by `elapse` (0: no time decay).
+   */
+  explicit FrequencySketch(const Vector<std::string> &labels, size_t width = 4096, int depth = 4,
+                           size_t heavyCount = 64, double halfLifeSeconds = 0)
+      : labels(labels), n((int)labels.size()), width(1), depth(depth < 1 ? 1 : depth),
+        increment(1), lookups(0), halfLife(halfLifeSeconds), heavyCount(heavyCount), minSlot(0)
+  {
+    while (this->width < width)
+      this->width *= 2;
+
+    counters.resize(this->width * this->depth);
+    for (size_t i = 0; i < counters.size(); i++)
+      counters[i] = 0;
+
+    seeds.resize(this->depth);
+    uint64_t seed = 0x5eed;
+    for (int row = 0; row < this->depth; row++)
+      seeds[row] = seed = mix(seed);
+  }
+
+  // Counts a successful lookup of key `index` (1..n)
+  void recordHit(int index)
+  {
+    if (index >= 1 && index <= n)
+      add(hitItem(index));
+  }
+
+  // Counts an unsuccessful lookup that fell in gap `gap` (0..n)
+  void recordMiss(int gap)
+  {
+    if (gap >= 0 && gap <= n)
+      add(missItem(gap));
+  }
+
+  // Counts the outcome of a `Tree::find`
+  void record(const LookupResult &result)
+  {
+    if (result.node)
+      recordHit(result.node->index);
+    else
+      recordMiss(result.gap);
+  }
+
+  // Counts a raw key from a log, placing it on its label or in its gap by binary search
+  void recordKey(std::string_view key)
+  {
+    int begin = 0, end = n;
+    while (begin < end)
+    {
+      int mid = begin + (end - begin) / 2;
+      if (Utils::compareStrings(labels[mid], key) < 0)
+        begin = mid + 1;
+      else
+        end = mid;
+    }
+
+    if (begin < n && Utils::compareStrings(labels[begin], key) == 0)
+      recordHit(begin + 1);
+    else
+      recordMiss(begin);
+  }
+
+  /**
+   * @brief Multiplies the weight of every lookup seen so far by `factor` (in (0, 1]).
+   */
+  void decay(double factor)
+  {
+    if (factor <= 0 || factor >= 1)
+      return;
+    increment /= factor;
+    if (increment > 1e100)
+      rescale();
+  }
+
+  // Decays the counts for `seconds` of elapsed time, using the half-life
+  void elapse(double seconds)
+  {
+    if (halfLife > 0 && seconds > 0)
+      decay(std::exp2(-seconds / halfLife));
+  }
+
+  // Estimated (decayed) number of lookups of key `index`, never below the true one
+  double estimateHits(int index) const
+  {
+    return (index >= 1 && index <= n) ? estimateScaled(hitItem(index)) / increment : 0;
+  }
+
+  // Estimated (decayed) number of misses in gap `gap`, never below the true one
+  double estimateMisses(int gap) const
+  {
+    return (gap >= 0 && gap <= n) ? estimateScaled(missItem(gap)) / increment : 0;
+  }
+
+  /**
+   * @brief The error bounds of the estimates, see `SketchReport`.
+   */
+  SketchReport getReport() const
+  {
+    SketchReport report;
+    report.lookups = lookups / increment;
+    report.epsilon = std::exp(1.0) / double(width);
+    report.delta = std::exp(-double(depth));
+    report.errorBound = report.epsilon * report.lookups;
+    return report;
+  }
+
+  /**
+   * @brief Turns the estimates into probabilities in the layout `OBST::generateTheOBST` expects.
+   *
+   * Each estimate is divided by the number of lookups actually counted, not by the sum of
+   * the estimates: every estimate carries collision noise, so with many keys that sum is far
+   * above the real traffic and would shrink every share. This way each p and q overestimates
+   * its true share by at most epsilon (with probability 1 - delta), and together they may sum
+   * to a little more than 1. Keys and gaps in the heavy-hitter list use their tracked count
+   * when it is tighter. P and Q are all zeros if nothing was counted.
+   *
+   * @return The error bounds of the estimates.
+   */
+  SketchReport exportProbabilities(Vector<float> &P, Vector<float> &Q) const
+  {
+    P.resize(n + 1);
+    Q.resize(n + 1);
+
+    double scale = (lookups == 0) ? 0.0 : 1.0 / lookups;
+    auto share = [scale](double estimate)
+    {
+      double value = estimate * scale;
+      return float(value > 1 ? 1 : value);
+    };
+
+    P[0] = 0;
+    for (int i = 1; i <= n; i++)
+      P[i] = share(estimateScaled(hitItem(i)));
+    for (int k = 0; k <= n; k++)
+      Q[k] = share(estimateScaled(missItem(k)));
+
+    // A heavy hitter's count was its estimate at its last lookup; collisions since then
+    // only raised the counters, so the smaller of the two is still an overestimate
+    for (size_t h = 0; h < heavy.size(); h++)
+    {
+      const HeavyHitter &entry = heavy[h];
+      float &target = entry.isGap ? Q[entry.index] : P[entry.index];
+      float tracked = share(entry.count);
+      if (tracked < target)
+        target = tracked;
+    }
+
+    return getReport();
+  }
+
+  /**
+   * @brief The heavy hitters, most looked-up first, with their estimated (decayed) counts.
+   */
+  Vector<HeavyHitter> getHeavyHitters() const
+  {
+    Vector<HeavyHitter> result = heavy;
+    for (size_t i = 0; i < result.size(); i++)
+      result[i].count /= increment;
+
+    // Insertion sort, the list is short
+    for (size_t i = 1; i < result.size(); i++)
+    {
+      HeavyHitter entry = result[i];
+      size_t j = i;
+      while (j > 0 && result[j - 1].count < entry.count)
+      {
+        result[j] = result[j - 1];
+        j--;
+      }
+      result[j] = entry;
+    }
+    return result;
+  }
+
+  /**
+   * @brief Adds the counts of another sketch with the same labels, width and depth.
+   *
+   * @return false (and prints why) if the sketches are not compatible.
+   */
+  bool merge(const FrequencySketch &other)
+  {
+    if (other.n != n || other.width != width || other.depth != depth)
+    {
+      std::cerr << "Cannot merge sketches of different sizes" << std::endl;
+      return false;
+    }
+
+    double factor = increment / other.increment;
+    for (size_t i = 0; i < counters.size(); i++)
+      counters[i] += other.counters[i] * factor;
+    lookups += other.lookups * factor;
+
+    // Tracked counts must stay overestimates for `exportProbabilities`, so every entry
+    // already listed is brought up to its merged estimate before the other list is added
+    for (size_t i = 0; i < heavy.size(); i++)
+      heavy[i].count = estimateScaled(heavy[i].isGap ? missItem(heavy[i].index) : hitItem(heavy[i].index));
+    findMinSlot();
+
+    for (size_t i = 0; i < other.heavy.size(); i++)
+    {
+      const HeavyHitter &entry = other.heavy[i];
+      uint64_t item = entry.isGap ? missItem(entry.index) : hitItem(entry.index);
+      updateHeavy(item, estimateScaled(item));
+    }
+    return true;
+  }
+
+  // Memory used by the counters and the heavy-hitter list, in bytes
+  size_t sizeInBytes() const
+  {
+    return counters.size() * sizeof(double) + heavyCount * (sizeof(HeavyHitter) + 2 * sizeof(uint64_t));
+  }
+
+  void printReport() const
+  {
+    SketchReport report = getReport();
+    std::cout << "Lookups (decayed): " << report.lookups << std::endl;
+    std::cout << "Sketch: " << depth << " x " << width << " counters, " << sizeInBytes() << " bytes" << std::endl;
+    std::cout << "Each p and q is overestimated by at most " << report.epsilon
+              << " with probability " << 1 - report.delta << std::endl;
+
+    Vector<HeavyHitter> top = getHeavyHitters();
+    size_t shown = top.size() < 10 ? top.size() : 10;
+    for (size_t i = 0; i < shown; i++)
+    {
+      const HeavyHitter &entry = top[i];
+      if (entry.isGap)
+        std::cout << "  gap " << entry.index;
+      else
+        std::cout << "  " << labels[entry.index - 1];
+      std::cout << ": " << entry.count << std::endl;
+    }
+  }
+};
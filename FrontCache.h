@@ -0,0 +1,252 @@
+/**
+ * @file FrontCache.h
+ * @brief A small direct-mapped cache of the most probable keys, checked before the tree.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include "Vector.h"
+#include "Tree.h"
+
+/**
+ * @class FrontCache
+ * @brief Answers lookups of the hottest keys with one probe instead of a tree descent.
+ *
+ * The keys with the highest p are placed in a direct-mapped table sized to fit the L1 cache.
+ * A lookup probes its slot first and falls through to the tree on a miss. Each slot holds
+ * the start of its key inline, so a hit on a key of up to `INLINE_KEY_BYTES` bytes reads
+ * nothing but the slot; only longer keys compare their tail against the node. The cache
+ * keeps a (shared, copy-on-write) copy of the tree, so the cached nodes stay valid.
+ */
+class FrontCache
+{
+public:
+  static constexpr size_t L1_BYTES = 32 * 1024;
+  static constexpr size_t INLINE_KEY_BYTES = 16;
+
+private:
+  struct Entry
+  {
+    uint32_t tag = 0;               // High bits of the key's hash
+    uint32_t length = 0;            // Length of the key
+    char prefix[INLINE_KEY_BYTES];  // The first bytes of the key
+    const TreeNode *node = nullptr; // null for an empty slot
+  };
+
+  static_assert(sizeof(Entry) == 32, "Cache slots must be 32 bytes");
+
+  Tree tree;
+  Vector<Entry> slots;
+  size_t mask;
+
+  std::atomic<uint64_t> lookups;
+  std::atomic<uint64_t> hits;
+
+  double treeCost;     // Expected comparisons per search in the tree alone: E[1][n] / W[1][n]
+  double cachedWeight; // Probability that a search is for a cached key
+  double savedCost;    // Expected comparisons per search that the cached keys no longer need
+
+  static uint64_t hashOf(const std::string &key)
+  {
+    // FNV-1a
+    uint64_t hash = 1469598103934665603ULL;
+    for (unsigned char c : key)
+    {
+      hash ^= c;
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  // Whether `slot` holds `key`, reading the node only for the part of a long key not held inline
+  static bool holds(const Entry &slot, const std::string &key, uint64_t hash)
+  {
+    if (!slot.node || slot.tag != uint32_t(hash >> 32) || slot.length != key.size())
+      return false;
+    if (key.size() <= INLINE_KEY_BYTES)
+      return std::memcmp(slot.prefix, key.data(), key.size()) == 0;
+    return std::memcmp(slot.prefix, key.data(), INLINE_KEY_BYTES) == 0 &&
+           slot.node->key.compare(INLINE_KEY_BYTES, std::string::npos, key, INLINE_KEY_BYTES) == 0;
+  }
+
+  // Sorts the key indices by decreasing p, keeping equal ones in order (bottom-up merge sort)
+  static void sortByProbability(Vector<int> &order, const Vector<float> &p)
+  {
+    size_t count = order.size();
+    Vector<int> buffer(count);
+    for (size_t run = 1; run < count; run *= 2)
+    {
+      for (size_t begin = 0; begin < count; begin += 2 * run)
+      {
+        size_t mid = (begin + run < count) ? begin + run : count;
+        size_t end = (begin + 2 * run < count) ? begin + 2 * run : count;
+        size_t left = begin, right = mid, out = begin;
+        while (left < mid && right < end)
+          buffer[out++] = (p[order[right]] > p[order[left]]) ? order[right++] : order[left++];
+        while (left < mid)
+          buffer[out++] = order[left++];
+        while (right < end)
+          buffer[out++] = order[right++];
+      }
+      std::swap(order, buffer);
+    }
+  }
+
+public:
+  /**
+   * @brief Fills the cache with the most probable keys of a built tree.
+   *
+   * @param tree The tree built from p (the cache keeps a shared copy of it).
+   * @param p Probabilities of successfully searching for each key (p[0] is unused).
+   * @param E The cost table of the DP.
+   * @param W The weight table of the DP.
+   * @param slotCount Number of slots, rounded down to a power of two (default: fills L1_BYTES).
+   */
+  FrontCache(const Tree &tree, const Vector<float> &p, const Vector<Vector<float>> &E, const Vector<Vector<float>> &W,
+             size_t slotCount = L1_BYTES / sizeof(Entry))
+      : tree(tree), mask(0), lookups(0), hits(0), treeCost(0), cachedWeight(0), savedCost(0)
+  {
+    size_t size = 1;
+    while (size * 2 <= slotCount)
+      size *= 2;
+    slots.resize(size);
+    mask = size - 1;
+
+    int n = (int)p.size() - 1;
+    if (n < 1)
+      return;
+
+    // Find each key's node and depth
+    Vector<const TreeNode *> nodeOf(n + 1);
+    Vector<int> depthOf(n + 1);
+    for (int i = 0; i <= n; i++)
+    {
+      nodeOf[i] = nullptr;
+      depthOf[i] = 0;
+    }
+
+    struct Frame
+    {
+      const TreeNode *node;
+      int depth;
+    };
+    Vector<Frame> stack;
+    if (this->tree.getRoot())
+      stack.push_back({this->tree.getRoot(), 0});
+    while (stack.size() > 0)
+    {
+      Frame top = stack.back();
+      stack.pop_back();
+      int index = top.node->index;
+      if (index >= 1 && index <= n)
+      {
+        nodeOf[index] = top.node;
+        depthOf[index] = top.depth;
+      }
+      if (top.node->left)
+        stack.push_back({top.node->left, top.depth + 1});
+      if (top.node->right)
+        stack.push_back({top.node->right, top.depth + 1});
+    }
+
+    // Most probable keys first, a slot already taken keeps its (more probable) key
+    Vector<int> order;
+    for (int i = 1; i <= n; i++)
+      if (nodeOf[i])
+        order.push_back(i);
+    sortByProbability(order, p);
+
+    double weight = W[1][n];
+    for (size_t k = 0; k < order.size(); k++)
+    {
+      int i = order[k];
+      const std::string &key = nodeOf[i]->key;
+      uint64_t hash = hashOf(key);
+      Entry &slot = slots[hash & mask];
+      if (slot.node)
+        continue;
+      slot.tag = uint32_t(hash >> 32);
+      slot.length = uint32_t(key.size());
+      std::memcpy(slot.prefix, key.data(), key.size() < INLINE_KEY_BYTES ? key.size() : INLINE_KEY_BYTES);
+      slot.node = nodeOf[i];
+      cachedWeight += p[i];
+      savedCost += p[i] * (depthOf[i] + 1);
+    }
+
+    treeCost = (weight == 0) ? 0.0 : E[1][n] / weight;
+    cachedWeight = (weight == 0) ? 0.0 : cachedWeight / weight;
+    savedCost = (weight == 0) ? 0.0 : savedCost / weight;
+  }
+
+  FrontCache(const FrontCache &) = delete;
+  FrontCache &operator=(const FrontCache &) = delete;
+
+  /**
+   * @brief Looks a key up, in the cache first and then in the tree.
+   */
+  LookupResult find(const std::string &key)
+  {
+    lookups.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t hash = hashOf(key);
+    const Entry &slot = slots[hash & mask];
+    if (holds(slot, key, hash))
+    {
+      hits.fetch_add(1, std::memory_order_relaxed);
+      LookupResult result;
+      result.node = slot.node;
+      return result;
+    }
+    return tree.find(key);
+  }
+
+  // Number of keys held in the cache
+  size_t cachedKeys() const
+  {
+    size_t count = 0;
+    for (size_t i = 0; i < slots.size(); i++)
+      if (slots[i].node)
+        count++;
+    return count;
+  }
+
+  // Share of the lookups so far answered by the cache
+  double hitRatio() const
+  {
+    uint64_t total = lookups.load(std::memory_order_relaxed);
+    return total == 0 ? 0.0 : double(hits.load(std::memory_order_relaxed)) / total;
+  }
+
+  // Hit ratio expected from p (probability that a search is for a cached key)
+  double expectedHitRatio() const
+  {
+    return cachedWeight;
+  }
+
+  // Expected comparisons per search without the cache, from the DP tables
+  double expectedTreeCost() const
+  {
+    return treeCost;
+  }
+
+  // Expected comparisons per search with the cache, counting the probe as one comparison
+  double expectedBlendedCost() const
+  {
+    return 1 + treeCost - savedCost;
+  }
+
+  void report() const
+  {
+    std::cout << "Cached Keys: " << cachedKeys() << " of " << slots.size() << " slots" << std::endl;
+    std::cout << "Hit Ratio (observed): " << hitRatio() << std::endl;
+    std::cout << "Hit Ratio (expected): " << expectedHitRatio() << std::endl;
+    std::cout << "Expected Cost without Cache: " << expectedTreeCost() << std::endl;
+    std::cout << "Expected Cost with Cache: " << expectedBlendedCost() << std::endl;
+  }
+};
@@ -0,0 +1,155 @@
+/**
+ * @file LabelIndex.h
+ * @brief A hash index from a label to its position in the labels, for O(1) duplicate checks and lookups.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "Vector.h"
+
+/**
+ * @class LabelIndex
+ * @brief Open-addressing hash map from label to position, built over an existing `Vector` of labels.
+ *
+ * The index stores positions only (and each label's hash, so growing never rehashes a
+ * string); the labels stay in the vector it was built over, which must outlive it.
+ * Slots are probed linearly and the table is kept at most half full.
+ *
+ * Labels appended to the vector are indexed with `add`. Any change that moves labels
+ * (sorting, removing one) must be followed by `rebuild`, which is O(n).
+ * Labels are matched exactly, like `Vector::findOne`.
+ */
+class LabelIndex
+{
+private:
+  struct Slot
+  {
+    size_t hash;
+    int32_t position; // -1 for an empty slot
+  };
+
+  Vector<Slot> slots; // Size is 0 or a power of two
+  const Vector<std::string> *labels;
+  size_t count;
+
+  static size_t hashOf(std::string_view label)
+  {
+    return std::hash<std::string_view>()(label);
+  }
+
+  // Places a slot known to be absent; there is always a free slot
+  void place(const Slot &slot)
+  {
+    size_t mask = slots.size() - 1;
+    size_t at = slot.hash & mask;
+    while (slots[at].position >= 0)
+      at = (at + 1) & mask;
+    slots[at] = slot;
+  }
+
+  // Makes room for `wanted` labels at half load
+  void grow(size_t wanted)
+  {
+    size_t capacity = slots.size() ? slots.size() : 16;
+    while (capacity < wanted * 2)
+      capacity *= 2;
+    if (capacity == slots.size())
+      return;
+
+    Vector<Slot> old = std::move(slots);
+    slots = Vector<Slot>(capacity);
+    for (size_t k = 0; k < capacity; k++)
+      slots[k].position = -1;
+    for (size_t k = 0; k < old.size(); k++)
+      if (old[k].position >= 0)
+        place(old[k]);
+  }
+
+  int find(std::string_view label, size_t hash) const
+  {
+    if (count == 0)
+      return -1;
+
+    size_t mask = slots.size() - 1;
+    for (size_t at = hash & mask; slots[at].position >= 0; at = (at + 1) & mask)
+    {
+      const Slot &slot = slots[at];
+      if (slot.hash == hash && (*labels)[slot.position] == label)
+        return slot.position;
+    }
+    return -1;
+  }
+
+public:
+  LabelIndex() : labels(nullptr), count(0) {}
+
+  explicit LabelIndex(const Vector<std::string> &labels) : labels(nullptr), count(0)
+  {
+    rebuild(labels);
+  }
+
+  /**
+   * @brief Starts an empty index over `newLabels`, whose labels are then indexed with `add`.
+   */
+  void reset(const Vector<std::string> &newLabels)
+  {
+    labels = &newLabels;
+    count = 0;
+    slots = Vector<Slot>();
+    grow(newLabels.size());
+  }
+
+  /**
+   * @brief Indexes every label of `newLabels`, dropping what was indexed before.
+   *
+   * With duplicated labels, the first position is kept.
+   */
+  void rebuild(const Vector<std::string> &newLabels)
+  {
+    reset(newLabels);
+    for (size_t i = 0; i < newLabels.size(); i++)
+      add(i);
+  }
+
+  /**
+   * @brief Indexes the label at `position`, already stored in the labels.
+   *
+   * @return false if that label is already indexed (at another position); it is not added.
+   */
+  bool add(size_t position)
+  {
+    const std::string &label = (*labels)[position];
+    size_t hash = hashOf(label);
+    if (find(label, hash) >= 0)
+      return false;
+
+    grow(count + 1);
+    place({hash, int32_t(position)});
+    count++;
+    return true;
+  }
+
+  /**
+   * @brief Returns the position of `label`, or -1 if it is not indexed.
+   */
+  int find(std::string_view label) const
+  {
+    return find(label, hashOf(label));
+  }
+
+  bool contains(std::string_view label) const
+  {
+    return find(label) >= 0;
+  }
+
+  // Number of labels indexed
+  size_t size() const
+  {
+    return count;
+  }
+};
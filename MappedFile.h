@@ -0,0 +1,186 @@
+/**
+ * @file MappedFile.h
+ * @brief Read-only access to a whole file, memory-mapped where the platform allows it.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define OBST_HAVE_MMAP 1
+#endif
+
+/**
+ * @class MappedFile
+ * @brief The read-only contents of a file, memory-mapped where possible and read into memory otherwise.
+ *
+ * Where files can be mapped, the file is opened once and everything (its identity, its
+ * size and its contents) comes from that one descriptor, so a file replaced in between
+ * cannot be mixed up with the one that was read.
+ */
+class MappedFile
+{
+private:
+  const char *bytes;
+  size_t length;
+  bool mapped;        // Whether `bytes` is a mapping (unmapped) or `buffer` (freed with it)
+  std::string buffer; // Fallback copy of the file
+#ifdef OBST_HAVE_MMAP
+  dev_t deviceId; // Identity of the file that was read (0 if none)
+  ino_t inodeId;
+
+  // Reads everything left in `fd` into the buffer
+  bool readAll(int fd)
+  {
+    char chunk[1 << 16];
+    while (true)
+    {
+      ssize_t got = ::read(fd, chunk, sizeof(chunk));
+      if (got == 0)
+        return true;
+      if (got < 0 && errno != EINTR)
+        return false;
+      if (got > 0)
+        buffer.append(chunk, size_t(got));
+    }
+  }
+#endif
+
+public:
+#ifdef OBST_HAVE_MMAP
+  MappedFile() : bytes(nullptr), length(0), mapped(false), deviceId(0), inodeId(0) {}
+#else
+  MappedFile() : bytes(nullptr), length(0), mapped(false) {}
+#endif
+
+  ~MappedFile()
+  {
+    close();
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  /**
+   * @brief Opens a file, replacing what was open before.
+   *
+   * @return true if the file could be read.
+   */
+  bool open(const std::string &filename)
+  {
+    close();
+
+#ifdef OBST_HAVE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    deviceId = info.st_dev;
+    inodeId = info.st_ino;
+
+    if (S_ISREG(info.st_mode))
+    {
+      length = size_t(info.st_size);
+      if (length == 0)
+      {
+        ::close(fd);
+        return true;
+      }
+
+      void *address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address != MAP_FAILED)
+      {
+        madvise(address, length, MADV_SEQUENTIAL);
+        ::close(fd);
+        bytes = static_cast<const char *>(address);
+        mapped = true;
+        return true;
+      }
+      length = 0;
+    }
+
+    // Not mappable (a pipe, or mmap failed), read it through the same descriptor
+    bool complete = readAll(fd);
+    ::close(fd);
+    if (!complete)
+    {
+      close();
+      return false;
+    }
+    bytes = buffer.data();
+    length = buffer.size();
+    return true;
+#else
+    // No mapping available, read the whole file instead
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+      return false;
+
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    buffer = contents.str();
+    bytes = buffer.data();
+    length = buffer.size();
+    return true;
+#endif
+  }
+
+  void close()
+  {
+#ifdef OBST_HAVE_MMAP
+    if (mapped)
+      munmap(const_cast<char *>(bytes), length);
+#endif
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+#ifdef OBST_HAVE_MMAP
+    deviceId = 0;
+    inodeId = 0;
+#endif
+  }
+
+  const char *data() const
+  {
+    return bytes;
+  }
+
+  size_t size() const
+  {
+    return length;
+  }
+
+  std::string_view view() const
+  {
+    return std::string_view(bytes ? bytes : "", length);
+  }
+
+#ifdef OBST_HAVE_MMAP
+  // Device and inode of the open file, taken from the descriptor it was read through
+  dev_t device() const
+  {
+    return deviceId;
+  }
+
+  ino_t inode() const
+  {
+    return inodeId;
+  }
+#endif
+};
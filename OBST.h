@@ -11,6 +11,25 @@
 #include "TreeNode.h"
 #include "Tree.h"
 #include "Utils.h"
+#include "TaskPool.h"
+
+/**
+ * @struct MorphStats
+ * What `OBST::morphTree` changed to turn the old tree into the new one.
+ */
+struct MorphStats
+{
+  int rotations = 0; // Rotations applied, each one rewrites the child pointers of two nodes
+  int inserted = 0;  // Nodes allocated for new keys
+  int removed = 0;   // Nodes freed for keys that are gone
+  int updated = 0;   // Kept nodes whose index or probability changed
+
+  // Number of node writes, an upper bound of the nodes touched
+  int touched() const
+  {
+    return 2 * rotations + inserted + removed + updated;
+  }
+};
 
 /**
  * @class OBST
@@ -18,6 +37,10 @@
  */
 class OBST
 {
+public:
+  // Ranges with more keys than this are built as separate tasks by the parallel builder
+  static constexpr int PARALLEL_BUILD_CUTOFF = 4096;
+
 private:
   /**
    * @brief Initializes the base cases for the dynamic programming tables.
@@ -37,7 +60,7 @@ private:
       // Base case for subtrees with one key: root is the key itself
       Root[a][a] = a;                   // The single key is the root
       W[a][a] = Q[a - 1] + P[a] + Q[a]; // Weight includes key and adjacent dummy keys
-      E[a][a] = W[a][a];                // Cost is equal to the weight for single keys
+      E[a][a] = Q[a - 1] + Q[a] + W[a][a]; // E[a][a-1] + E[a+1][a] + W[a][a]: the dummy keys sit one level below
     }
 
     // Handle the edge case for the last dummy key
@@ -80,46 +103,254 @@ private:
     }
   }
 
+  /**
+   * @brief A pending range [i, j] of the root table and the child pointer its subtree goes into.
+   */
+  struct BuildFrame
+  {
+    int i, j;
+    TreeNode **slot;
+  };
+
   /**
    * @brief Builds a binary tree from the root table.
    *
-   * The function uses recursive calls to construct the tree by looking up
-   * the root table. It breaks the tree into left and right subtrees based
-   * on the optimal root for each range.
+   * The function constructs the tree by looking up the root table. It breaks
+   * the tree into left and right subtrees based on the optimal root for each range.
+   * Pending ranges are kept on an explicit stack, so skewed (very deep) trees
+   * cannot overflow the call stack. Each node keeps its key index and probability.
    */
-  TreeNode static *buildTreeFromRoot(const Vector<Vector<float>> &root, const Vector<std::string> &labels, int i, int j)
+  TreeNode static *buildTreeFromRoot(const Vector<Vector<float>> &root, const Vector<std::string> &labels, const Vector<float> &P, int i, int j)
   {
-    // Base case: If the range is invalid, return null
-    if (i > j || root[i][j] == 0)
-      return nullptr;
+    TreeNode *result = nullptr;
+    try
+    {
+      Vector<BuildFrame> stack;
+      stack.push_back({i, j, &result});
 
-    // Get the root index for the range [i, j]
-    int r = int(root[i][j]);
+      while (stack.size() > 0)
+      {
+        BuildFrame range = stack.back();
+        stack.pop_back();
+
+        // Base case: If the range is invalid, leave the child empty
+        if (range.i > range.j || root[range.i][range.j] == 0)
+          continue;
 
-    // Create a new tree node for this root
-    TreeNode *node = new TreeNode(labels[r - 1]); // Labels are 0-indexed
+        // Get the root index for the range [i, j]
+        int r = int(root[range.i][range.j]);
 
-    // Recursively build the left and right subtrees
-    node->left = buildTreeFromRoot(root, labels, i, r - 1);  // Left subtree is [i, r-1]
-    node->right = buildTreeFromRoot(root, labels, r + 1, j); // Right subtree is [r+1, j]
+        // Create a new tree node for this root
+        TreeNode *node = new TreeNode(labels[r - 1], r, P[r]); // Labels are 0-indexed
+        *range.slot = node;
 
-    return node; // Return the constructed node
+        // Build the left and right subtrees later
+        stack.push_back({r + 1, range.j, &node->right}); // Right subtree is [r+1, j]
+        stack.push_back({range.i, r - 1, &node->left});  // Left subtree is [i, r-1]
+      }
+    }
+    catch (...)
+    {
+      // Every node is linked as soon as it is made, so the partial tree frees them all
+      Tree partial;
+      partial.setRoot(result);
+      throw;
+    }
+
+    return result; // Return the constructed tree
   }
 
   /**
    * @brief Converts the root table into a complete binary tree.
    *
    * This is a helper function to create the `Tree` object using
-   * the root table and the provided labels.
+   * the root table and the provided labels. The probabilities are kept
+   * in the tree so it can report its expected search cost.
    */
-  Tree static convertToTree(const Vector<Vector<float>> &root, const Vector<std::string> &labels, int n)
+  Tree static convertToTree(const Vector<Vector<float>> &root, const Vector<std::string> &labels,
+                            const Vector<float> &P, const Vector<float> &Q, int n)
   {
     Tree tree;
-    tree.setRoot(buildTreeFromRoot(root, labels, 1, n)); // Build the full tree
-    return tree;                                         // Return the constructed tree
+    tree.setRoot(buildTreeFromRoot(root, labels, P, 1, n)); // Build the full tree
+    tree.setGapWeights(Q);                                  // Keep q for the weighted statistics
+    return tree;                                            // Return the constructed tree
+  }
+
+  /**
+   * @brief Builds the subtree of the range [i, j] into `slot`, splitting large ranges into tasks.
+   *
+   * Once `r` is known the left and right subtrees are independent: a large left
+   * range is handed to the pool while this task carries on with the right one.
+   * Each task only writes its own child pointer, so no locking is needed.
+   * Ranges of at most `cutoff` keys are built sequentially.
+   */
+  void static buildSubtreeTask(const Vector<Vector<float>> &root, const Vector<std::string> &labels, const Vector<float> &P,
+                               int i, int j, TreeNode **slot, TaskGroup &group, int cutoff)
+  {
+    while (j - i + 1 > cutoff && root[i][j] != 0)
+    {
+      int r = int(root[i][j]);
+      TreeNode *node = new TreeNode(labels[r - 1], r, P[r]); // Labels are 0-indexed
+      *slot = node;
+
+      // Left subtree is [i, r-1]
+      if (r - i > cutoff)
+        group.run([&root, &labels, &P, i, r, node, &group, cutoff]
+                  { buildSubtreeTask(root, labels, P, i, r - 1, &node->left, group, cutoff); });
+      else
+        node->left = buildTreeFromRoot(root, labels, P, i, r - 1);
+
+      // Right subtree is [r+1, j], continue with it in this task
+      i = r + 1;
+      slot = &node->right;
+    }
+
+    *slot = buildTreeFromRoot(root, labels, P, i, j);
+  }
+
+  /**
+   * @brief Rotates the node with key index `target` up until it is the root of the subtree in `slot`.
+   *
+   * The subtree must hold `target`, and its nodes must carry their current key indices.
+   */
+  void static rotateUp(TreeNode **slot, int target, MorphStats &stats)
+  {
+    Vector<TreeNode **> path; // path[k] holds the k-th node on the way down to the target
+    TreeNode **current = slot;
+    while ((*current)->index != target)
+    {
+      path.push_back(current);
+      current = (target < (*current)->index) ? &(*current)->left : &(*current)->right;
+    }
+
+    TreeNode *node = *current;
+    while (path.size() > 0)
+    {
+      TreeNode **parentSlot = path.back();
+      path.pop_back();
+      TreeNode *parent = *parentSlot;
+
+      if (parent->left == node)
+      {
+        parent->left = node->right;
+        node->right = parent;
+      }
+      else
+      {
+        parent->right = node->left;
+        node->left = parent;
+      }
+      *parentSlot = node;
+      stats.rotations++;
+    }
+  }
+
+  // Removes the node with `key` from the subtree in `slot`, rotating it down until it has at most one child
+  void static removeKey(TreeNode **slot, const std::string &key, MorphStats &stats)
+  {
+    while (*slot)
+    {
+      int cmp = Utils::compareStrings(key, (*slot)->key);
+      if (cmp == 0)
+        break;
+      slot = (cmp < 0) ? &(*slot)->left : &(*slot)->right;
+    }
+
+    TreeNode *node = *slot;
+    if (!node)
+      return;
+
+    while (node->left && node->right)
+    {
+      TreeNode *left = node->left;
+      node->left = left->right;
+      left->right = node;
+      *slot = left;
+      slot = &left->right;
+      stats.rotations++;
+    }
+
+    *slot = node->left ? node->left : node->right;
+    delete node;
+    stats.removed++;
+  }
+
+  // Inserts `node` as a leaf of the subtree in `slot`
+  void static insertLeaf(TreeNode **slot, TreeNode *node, MorphStats &stats)
+  {
+    while (*slot)
+    {
+      int cmp = Utils::compareStrings(node->key, (*slot)->key);
+      slot = (cmp < 0) ? &(*slot)->left : &(*slot)->right;
+    }
+    *slot = node;
+    stats.inserted++;
   }
 
 public:
+  /**
+   * @brief Fills the cost, weight and root tables for the given probabilities.
+   *
+   * @param p Probabilities of successfully searching for each key (p[0] is unused).
+   * @param q Probabilities of searching for dummy keys.
+   * @param e Output cost table, resized to (n + 2) x (n + 2).
+   * @param w Output weight table, resized to (n + 2) x (n + 2).
+   * @param root Output root table, resized to (n + 2) x (n + 2).
+   */
+  void static computeTables(const Vector<float> &p, const Vector<float> &q,
+                            Vector<Vector<float>> &e, Vector<Vector<float>> &w, Vector<Vector<float>> &root)
+  {
+    int n = p.size() - 1; // Number of keys (p[0] is unused)
+
+    // Create 2D Vectors for cost, weight, and root
+    e = Utils::create2D<float>(n + 2, n + 2);
+    w = Utils::create2D<float>(n + 2, n + 2);
+    root = Utils::create2D<float>(n + 2, n + 2);
+
+    // Initialize base cases
+    initializeLoop(e, w, root, n, p, q);
+
+    // Compute the tables for all subtrees
+    computeOBST(e, w, root, n, p, q);
+  }
+
+  /**
+   * @brief Converts a finished root table into a tree, building independent subtrees in parallel.
+   *
+   * @param root The root table computed by `computeTables`.
+   * @param labels Names of the keys (sorted).
+   * @param P Probabilities of successfully searching for each key (p[0] is unused).
+   * @param Q Probabilities of searching for dummy keys.
+   * @param pool The pool running the subtree tasks (default: the shared pool).
+   * @param cutoff Ranges with at most this many keys are built sequentially.
+   * @return Tree The constructed tree, identical to the one built sequentially.
+   */
+  Tree static convertToTreeParallel(const Vector<Vector<float>> &root, const Vector<std::string> &labels,
+                                    const Vector<float> &P, const Vector<float> &Q,
+                                    TaskPool &pool = TaskPool::shared(), int cutoff = PARALLEL_BUILD_CUTOFF)
+  {
+    int n = labels.size();
+    TreeNode *result = nullptr;
+    try
+    {
+      TaskGroup group(pool);
+      buildSubtreeTask(root, labels, P, 1, n, &result, group, cutoff < 1 ? 1 : cutoff);
+      group.wait();
+    }
+    catch (...)
+    {
+      // The group has drained by now, and every node built by any task is linked under `result`
+      Tree partial;
+      partial.setRoot(result);
+      throw;
+    }
+
+    Tree tree;
+    tree.setRoot(result);
+    tree.setGapWeights(Q);
+    return tree;
+  }
+
   void static displayTables(const Vector<Vector<float>> &E, const Vector<Vector<float>> &W, const Vector<Vector<float>> &Root)
   {
     int n = E.size() - 1;
@@ -148,28 +379,164 @@ public:
    * @return Tree The constructed Optimal Binary Search Tree.
    */
   Tree static generateTheOBST(const Vector<float> &p, const Vector<float> &q, const Vector<std::string> &labels, bool _displayTables = false)
+  {
+    // Compute the cost, weight, and root tables
+    Vector<Vector<float>> e, w, root;
+    Tree tree = generateTheOBST(p, q, labels, e, w, root);
+
+    // Display the tables if u want
+    if (_displayTables)
+    {
+      displayTables(e, w, root);
+    }
+
+    return tree;
+  }
+
+  /**
+   * @brief Generates an Optimal Binary Search Tree and keeps the tables it was built from.
+   *
+   * @param e Output cost table, as filled by `computeTables`.
+   * @param w Output weight table.
+   * @param root Output root table.
+   * @see generateTheOBST(const Vector<float> &, const Vector<float> &, const Vector<std::string> &, bool)
+   */
+  Tree static generateTheOBST(const Vector<float> &p, const Vector<float> &q, const Vector<std::string> &labels,
+                              Vector<Vector<float>> &e, Vector<Vector<float>> &w, Vector<Vector<float>> &root)
   {
     int n = p.size() - 1; // Number of keys (p[0] is unused)
+    computeTables(p, q, e, w, root);
 
-    // Create 2D Vectors for cost, weight, and root
-    Vector<Vector<float>> e = Utils::create2D<float>(n + 2, n + 2);
-    Vector<Vector<float>> w = Utils::create2D<float>(n + 2, n + 2);
-    Vector<Vector<float>> root = Utils::create2D<float>(n + 2, n + 2);
+    // Build and return the OBST as a Tree object, large trees are built on all cores
+    if (n > PARALLEL_BUILD_CUTOFF)
+      return convertToTreeParallel(root, labels, p, q);
+    return convertToTree(root, labels, p, q, n);
+  }
 
-    // Initialize base cases
-    initializeLoop(e, w, root, n, p, q);
+  /**
+   * @brief Turns `tree` into the tree of the root table in place, instead of building a new one.
+   *
+   * Nodes of keys that are gone are removed and new keys are inserted as leaves, then the
+   * tree is reshaped top-down: wherever a subtree's root differs from the root table, the
+   * right node is rotated up to it. Subtrees that already match are only read, so a small
+   * change of the distribution costs a small number of writes. The result has the same
+   * shape as the tree `generateTheOBST` would build.
+   *
+   * If `tree` shares its nodes with other copies they are duplicated first (copy-on-write).
+   *
+   * @param tree The tree to change, built from an older distribution or key set.
+   * @param root The root table computed by `computeTables` for the new distribution.
+   * @param labels Names of the keys (sorted).
+   * @param P Probabilities of successfully searching for each key (p[0] is unused).
+   * @param Q Probabilities of searching for dummy keys.
+   * @return What was changed (see `MorphStats`).
+   */
+  MorphStats static morphTree(Tree &tree, const Vector<Vector<float>> &root, const Vector<std::string> &labels,
+                              const Vector<float> &P, const Vector<float> &Q)
+  {
+    MorphStats stats;
+    int n = labels.size();
 
-    // Compute the tables for all subtrees
-    computeOBST(e, w, root, n, p, q);
+    // Find the keys to remove and to insert by walking the old keys and the labels side by side
+    Vector<std::string> gone;
+    Vector<int> added;
+    {
+      Tree::Iterator it = tree.begin(), end = tree.end();
+      int k = 0;
+      while (it != end || k < n)
+      {
+        int cmp = (it == end) ? 1 : (k == n) ? -1
+                                             : Utils::compareStrings(it->key, labels[k]);
+        if (cmp < 0)
+        {
+          gone.push_back(it->key);
+          ++it;
+        }
+        else if (cmp > 0)
+        {
+          added.push_back(k + 1);
+          k++;
+        }
+        else
+        {
+          ++it;
+          k++;
+        }
+      }
+    }
 
-    // Display the tables if u want
-    if (_displayTables)
+    TreeNode *top = tree.getMutableRoot();
+
+    for (size_t g = 0; g < gone.size(); g++)
+      removeKey(&top, gone[g], stats);
+
+    for (size_t a = 0; a < added.size(); a++)
     {
-      displayTables(e, w, root);
+      int r = added[a];
+      insertLeaf(&top, new TreeNode(labels[r - 1], r, P[r]), stats); // Labels are 0-indexed
+    }
+
+    // Give every node its new key index and probability, in order
+    {
+      Vector<TreeNode *> stack;
+      TreeNode *node = top;
+      int k = 0;
+      while (node || stack.size() > 0)
+      {
+        while (node)
+        {
+          stack.push_back(node);
+          node = node->left;
+        }
+        node = stack.back();
+        stack.pop_back();
+
+        k++;
+        if (node->index != k || node->p != P[k])
+        {
+          node->index = k;
+          node->p = P[k];
+          stats.updated++;
+        }
+        node = node->right;
+      }
     }
 
-    // Build and return the OBST as a Tree object
-    return convertToTree(root, labels, n);
+    // Reshape top-down, the subtree in `slot` holds exactly the keys [i, j]
+    Vector<BuildFrame> stack;
+    stack.push_back({1, n, &top});
+    while (stack.size() > 0)
+    {
+      BuildFrame range = stack.back();
+      stack.pop_back();
+
+      if (range.i > range.j || root[range.i][range.j] == 0)
+        continue;
+
+      int r = int(root[range.i][range.j]);
+      if ((*range.slot)->index != r)
+        rotateUp(range.slot, r, stats);
+
+      TreeNode *node = *range.slot;
+      stack.push_back({r + 1, range.j, &node->right});
+      stack.push_back({range.i, r - 1, &node->left});
+    }
+
+    tree.setRoot(top);
+    tree.setGapWeights(Q);
+    return stats;
+  }
+
+  /**
+   * @brief Computes the tables for the new distribution and morphs `tree` into its OBST.
+   *
+   * @see morphTree(Tree &, const Vector<Vector<float>> &, const Vector<std::string> &, const Vector<float> &, const Vector<float> &)
+   */
+  MorphStats static morphTree(Tree &tree, const Vector<float> &p, const Vector<float> &q, const Vector<std::string> &labels)
+  {
+    Vector<Vector<float>> e, w, root;
+    computeTables(p, q, e, w, root);
+    return morphTree(tree, root, labels, p, q);
   }
 
   void static addNode(std::string nodeLabel, float p, float q, Vector<std::string> &labels, Vector<float> &P, Vector<float> &Q)
@@ -179,6 +546,6 @@ public:
     P.push_back(p);
     Q.push_back(q);
 
-    Utils::sortInputs(labels, P);
+    Utils::sortInputs(labels, P, Q); // q was given with the key, so it moves with it
   }
 };
@@ -0,0 +1,431 @@
+/**
+ * @file SessionSnapshot.h
+ * @brief Saves and restores a whole session (inputs, tables and tree) in a checksummed binary file.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "Vector.h"
+#include "BufferedWriter.h"
+#include "FileReplace.h"
+#include "TreeNode.h"
+#include "Tree.h"
+#include "OBST.h"
+#include "Utils.h"
+
+/**
+ * @struct Session
+ * Everything needed to pick a session up where it was left.
+ */
+struct Session
+{
+  Vector<std::string> labels; // Names of the keys (sorted)
+  Vector<float> p;            // Probabilities of successful search (p[0] is unused)
+  Vector<float> q;            // Probabilities of un-successful search
+  bool useQ = false;          // Whether q was entered by the user
+  Tree tree;                  // The built tree (empty if not built)
+
+  bool hasTables = false; // Whether e, w and root hold the DP tables
+  Vector<Vector<float>> e, w, root;
+};
+
+/**
+ * @class SessionSnapshot
+ * @brief Reads and writes `Session`s.
+ *
+ * File layout (native byte order):
+ * - Header: "OBSTSESS", version (uint32), flags (uint32), payload size (uint64),
+ *   FNV-1a checksum of the payload (uint64).
+ * - Payload: n (int64), the labels (uint32 length + bytes each), p and q (n + 1 floats each),
+ *   then if flagged the E, W and Root tables (the cells [i][j] with 1 <= i <= n + 1 and
+ *   i - 1 <= j <= n, row by row), then if flagged the tree as the key indices in preorder
+ *   (int32 each), which together with the sorted labels gives back its exact shape.
+ *
+ * Restoring a session with its tables and tree does not run the DP again. A new file is
+ * written next to the old one and renamed over it, so a failed save keeps the old session.
+ */
+class SessionSnapshot
+{
+public:
+  static constexpr uint32_t VERSION = 1;
+
+private:
+  // Bits of the flags field
+  static constexpr uint32_t USE_Q = 1;
+  static constexpr uint32_t HAS_TABLES = 2;
+  static constexpr uint32_t HAS_TREE = 4;
+
+  static constexpr size_t HEADER_BYTES = 8 + 4 + 4 + 8 + 8;
+  static constexpr size_t BUFFER_BYTES = 1 << 20;
+
+  /**
+   * @brief Reads the payload in large blocks, checksumming it and never reading past its end.
+   */
+  class PayloadReader
+  {
+  private:
+    std::ifstream &in;
+    std::string buffer;
+    size_t position = 0;
+    uint64_t remaining; // Payload bytes not yet read from the file
+
+  public:
+    uint64_t checksum = BufferedWriter::CHECKSUM_SEED;
+    uint64_t left; // Payload bytes not yet consumed
+
+    PayloadReader(std::ifstream &in, uint64_t size) : in(in), remaining(size), left(size) {}
+
+    bool get(void *bytes, size_t count)
+    {
+      if (count > left)
+        return false;
+
+      char *data = static_cast<char *>(bytes);
+      while (count > 0)
+      {
+        if (position == buffer.size())
+        {
+          size_t block = remaining < BUFFER_BYTES ? size_t(remaining) : BUFFER_BYTES;
+          buffer.resize(block);
+          if (!in.read(&buffer[0], block))
+            return false;
+          checksum = BufferedWriter::checksumOf(buffer.data(), block, checksum);
+          remaining -= block;
+          position = 0;
+        }
+
+        size_t take = buffer.size() - position;
+        if (take > count)
+          take = count;
+        std::memcpy(data, buffer.data() + position, take);
+        position += take;
+        data += take;
+        count -= take;
+        left -= take;
+      }
+      return true;
+    }
+
+    template <typename T>
+    bool get(T &value)
+    {
+      return get(&value, sizeof(T));
+    }
+  };
+
+  static void writeTable(BufferedWriter &out, const Vector<Vector<float>> &table, int64_t n)
+  {
+    for (int64_t i = 1; i <= n + 1; i++)
+      for (int64_t j = i - 1; j <= n; j++)
+        out.putValue(table[i][j]);
+  }
+
+  static bool readTable(PayloadReader &in, Vector<Vector<float>> &table, int64_t n)
+  {
+    table = Utils::create2D<float>(n + 2, n + 2);
+    for (int64_t i = 1; i <= n + 1; i++)
+      for (int64_t j = i - 1; j <= n; j++)
+        if (!in.get(table[i][j]))
+          return false;
+    return true;
+  }
+
+  // Rebuilds a tree from the key indices in preorder, false if they are not the preorder of a BST on 1..n
+  static bool buildFromPreorder(const Vector<int32_t> &order, const Vector<std::string> &labels, const Vector<float> &p, Tree &tree)
+  {
+    int64_t n = labels.size();
+    TreeNode *root = nullptr;
+    Vector<TreeNode *> stack;
+
+    for (size_t k = 0; k < order.size(); k++)
+    {
+      int32_t r = order[k];
+      if (r < 1 || r > n)
+      {
+        tree.setRoot(root);
+        return false;
+      }
+
+      TreeNode *node = new TreeNode(labels[r - 1], r, p[r]);
+      if (!root)
+      {
+        root = node;
+      }
+      else if (r < stack.back()->index)
+      {
+        stack.back()->left = node;
+      }
+      else
+      {
+        // The node is the right child of the last ancestor smaller than it
+        TreeNode *parent = nullptr;
+        while (stack.size() > 0 && stack.back()->index < r)
+        {
+          parent = stack.back();
+          stack.pop_back();
+        }
+        if (!parent || parent->right)
+        {
+          delete node;
+          tree.setRoot(root);
+          return false;
+        }
+        parent->right = node;
+      }
+      stack.push_back(node);
+    }
+    tree.setRoot(root);
+
+    // A valid shape visits 1..n in order
+    int expected = 1;
+    for (const TreeNode &node : tree)
+      if (node.index != expected++)
+        return false;
+    return expected == n + 1;
+  }
+
+  // Whether the tables are (n + 2) x (n + 2) and every root[i][j] is a key of i..j, so a tree can be built from them
+  static bool validTables(const Session &session, int64_t n)
+  {
+    const Vector<Vector<float>> *tables[] = {&session.e, &session.w, &session.root};
+    for (const Vector<Vector<float>> *table : tables)
+    {
+      if ((int64_t)table->size() != n + 2)
+        return false;
+      for (int64_t i = 0; i < n + 2; i++)
+        if ((int64_t)(*table)[i].size() != n + 2)
+          return false;
+    }
+
+    for (int64_t i = 1; i <= n; i++)
+      for (int64_t j = i; j <= n; j++)
+      {
+        float r = session.root[i][j];
+        if (!(r >= float(i) && r <= float(j)) || r != float(int64_t(r)))
+          return false;
+      }
+    return true;
+  }
+
+public:
+  /**
+   * @brief Writes the session to a file.
+   *
+   * The tables are written if `session.hasTables`, the tree if its nodes carry their key indices.
+   *
+   * @return true on success; on failure the error is printed.
+   */
+  static bool save(const std::string &filename, const Session &session)
+  {
+    int64_t n = session.labels.size();
+    if ((int64_t)session.p.size() != n + 1 || (int64_t)session.q.size() != n + 1)
+    {
+      std::cerr << "Inconsistent session: p and q must have n + 1 entries" << std::endl;
+      return false;
+    }
+
+    // The shape is stored by key index, so only a tree whose nodes carry them is kept
+    bool keepTree = !session.tree.isEmpty();
+    int64_t expected = 1;
+    for (const TreeNode &node : session.tree)
+      keepTree = keepTree && node.index == expected++;
+    keepTree = keepTree && expected == n + 1;
+
+    // Written next to the target and renamed over it, so a failed save keeps the previous session
+    std::string temporary = FileReplace::temporaryFor(filename);
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+      std::cerr << "Failed to open file: " << temporary << std::endl;
+      return false;
+    }
+
+    uint32_t flags = (session.useQ ? USE_Q : 0u) | (session.hasTables ? HAS_TABLES : 0u) | (keepTree ? HAS_TREE : 0u);
+
+    // Header with a placeholder size and checksum, filled in once the payload is written
+    char header[HEADER_BYTES] = {};
+    file.write(header, HEADER_BYTES);
+
+    BufferedWriter out(file, true);
+    out.putValue(n);
+    for (int64_t i = 0; i < n; i++)
+    {
+      const std::string &label = session.labels[i];
+      uint32_t length = label.size();
+      out.putValue(length);
+      out.putBytes(label.data(), length);
+    }
+    for (int64_t i = 0; i <= n; i++)
+      out.putValue(session.p[i]);
+    for (int64_t i = 0; i <= n; i++)
+      out.putValue(session.q[i]);
+
+    if (flags & HAS_TABLES)
+    {
+      writeTable(out, session.e, n);
+      writeTable(out, session.w, n);
+      writeTable(out, session.root, n);
+    }
+
+    if (flags & HAS_TREE)
+    {
+      Vector<const TreeNode *> stack;
+      stack.push_back(session.tree.getRoot());
+      while (stack.size() > 0)
+      {
+        const TreeNode *node = stack.back();
+        stack.pop_back();
+        int32_t index = node->index;
+        out.putValue(index);
+        if (node->right)
+          stack.push_back(node->right);
+        if (node->left)
+          stack.push_back(node->left);
+      }
+    }
+    out.flush();
+
+    std::memcpy(header, "OBSTSESS", 8);
+    std::memcpy(header + 8, &VERSION, 4);
+    std::memcpy(header + 12, &flags, 4);
+    uint64_t size = out.size(), checksum = out.checksum();
+    std::memcpy(header + 16, &size, 8);
+    std::memcpy(header + 24, &checksum, 8);
+    file.seekp(0);
+    file.write(header, HEADER_BYTES);
+    file.flush();
+
+    if (!file.good())
+    {
+      std::cerr << "Failed to write file: " << temporary << std::endl;
+      file.close();
+      std::remove(temporary.c_str());
+      return false;
+    }
+    file.close();
+
+    if (!FileReplace::commit(temporary, filename))
+    {
+      std::cerr << "Failed to write file: " << filename << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Restores a session written by `save`.
+   *
+   * Nothing is recomputed when the file holds the tree. A file with only the root table
+   * gets its tree rebuilt from it, and a file with only the inputs runs the DP.
+   *
+   * @return true on success; on failure `session` is unchanged and the error is printed.
+   */
+  static bool load(const std::string &filename, Session &session)
+  {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+    {
+      std::cerr << "Failed to open file: " << filename << std::endl;
+      return false;
+    }
+
+    char header[HEADER_BYTES];
+    uint32_t version, flags;
+    uint64_t size, checksum;
+    if (!file.read(header, HEADER_BYTES) || std::memcmp(header, "OBSTSESS", 8) != 0)
+    {
+      std::cerr << "Not a session snapshot: " << filename << std::endl;
+      return false;
+    }
+    std::memcpy(&version, header + 8, 4);
+    std::memcpy(&flags, header + 12, 4);
+    std::memcpy(&size, header + 16, 8);
+    std::memcpy(&checksum, header + 24, 8);
+    if (version != VERSION)
+    {
+      std::cerr << "Unsupported session snapshot version " << version << " in: " << filename << std::endl;
+      return false;
+    }
+
+    Session loaded;
+    PayloadReader in(file, size);
+    int64_t n;
+    // Every key takes at least 12 bytes (length, p and q), which bounds n before allocating
+    bool ok = in.get(n) && n >= 0 && uint64_t(n) <= in.left / 12;
+    if (ok)
+    {
+      loaded.labels.resize(n);
+      for (int64_t i = 0; i < n && ok; i++)
+      {
+        uint32_t length;
+        ok = in.get(length) && length <= in.left;
+        if (ok)
+        {
+          loaded.labels[i].resize(length);
+          ok = in.get(&loaded.labels[i][0], length);
+        }
+      }
+    }
+    if (ok)
+    {
+      loaded.p.resize(n + 1);
+      loaded.q.resize(n + 1);
+      for (int64_t i = 0; i <= n && ok; i++)
+        ok = in.get(loaded.p[i]);
+      for (int64_t i = 0; i <= n && ok; i++)
+        ok = in.get(loaded.q[i]);
+    }
+    if (ok && (flags & HAS_TABLES))
+    {
+      uint64_t cells = uint64_t(n + 1) * uint64_t(n + 2) / 2;
+      ok = cells * 3 * sizeof(float) <= in.left && readTable(in, loaded.e, n) && readTable(in, loaded.w, n) && readTable(in, loaded.root, n);
+      loaded.hasTables = ok;
+    }
+
+    Vector<int32_t> order;
+    if (ok && (flags & HAS_TREE))
+    {
+      ok = uint64_t(n) * sizeof(int32_t) <= in.left;
+      order.resize(ok ? n : 0);
+      for (int64_t k = 0; k < n && ok; k++)
+        ok = in.get(order[k]);
+    }
+
+    // The checksum only catches accidents, the root table must also be safe to build from
+    if (ok && loaded.hasTables)
+      ok = validTables(loaded, n);
+
+    if (!ok || in.left != 0 || in.checksum != checksum)
+    {
+      std::cerr << "Corrupted session snapshot: " << filename << std::endl;
+      return false;
+    }
+
+    loaded.useQ = (flags & USE_Q) != 0;
+    if (flags & HAS_TREE)
+    {
+      if (!buildFromPreorder(order, loaded.labels, loaded.p, loaded.tree))
+      {
+        std::cerr << "Corrupted tree in session snapshot: " << filename << std::endl;
+        return false;
+      }
+      loaded.tree.setGapWeights(loaded.q);
+    }
+    else if (loaded.hasTables)
+    {
+      loaded.tree = OBST::convertToTreeParallel(loaded.root, loaded.labels, loaded.p, loaded.q);
+    }
+    else if (n > 0)
+    {
+      loaded.tree = OBST::generateTheOBST(loaded.p, loaded.q, loaded.labels);
+    }
+
+    session = std::move(loaded);
+    return true;
+  }
+};
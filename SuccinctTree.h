@@ -0,0 +1,608 @@
+/**
+ * @file SuccinctTree.h
+ * @brief Compact, read-only encoding of a built tree that can be searched without decoding it.
+ *
+ * The shape is stored as a level-order bit sequence (LOUDS for binary trees, 2 bits per node),
+ * the keys are stored once in sorted order, and a bit-packed permutation maps each node
+ * to its key. Navigation uses rank/select on the shape bits.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "Vector.h"
+#include "TreeNode.h"
+#include "Tree.h"
+#include "Utils.h"
+
+/**
+ * @class RankBits
+ * @brief A bit sequence with a small rank directory for fast rank and select.
+ *
+ * The number of ones before every block of 512 bits is kept, which costs
+ * 32 bits per block (about 6% on top of the bits themselves).
+ */
+class RankBits
+{
+private:
+  static constexpr size_t WORDS_PER_BLOCK = 8; // 8 * 64 = 512 bits per block
+
+  Vector<uint64_t> words;  // The bits, 64 per word
+  Vector<uint32_t> blocks; // Number of ones before each block
+  size_t bitCount;         // Number of bits in use
+
+  static int popcount(uint64_t word)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for (; word; word &= word - 1)
+      count++;
+    return count;
+#endif
+  }
+
+public:
+  RankBits() : bitCount(0) {}
+
+  void resize(size_t bits)
+  {
+    bitCount = bits;
+    words.resize((bits + 63) / 64);
+    for (size_t i = 0; i < words.size(); i++)
+      words[i] = 0;
+  }
+
+  void set(size_t pos)
+  {
+    words[pos / 64] |= uint64_t(1) << (pos % 64);
+  }
+
+  bool get(size_t pos) const
+  {
+    return (words[pos / 64] >> (pos % 64)) & 1;
+  }
+
+  size_t size() const
+  {
+    return bitCount;
+  }
+
+  // Must be called once all the bits are set
+  void buildDirectory()
+  {
+    size_t blockCount = (words.size() + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK;
+    blocks.resize(blockCount);
+    uint32_t ones = 0;
+    for (size_t w = 0; w < words.size(); w++)
+    {
+      if (w % WORDS_PER_BLOCK == 0)
+        blocks[w / WORDS_PER_BLOCK] = ones;
+      ones += popcount(words[w]);
+    }
+  }
+
+  /**
+   * @brief Number of ones in the bits [0, pos] (inclusive).
+   */
+  size_t rank1(size_t pos) const
+  {
+    size_t word = pos / 64;
+    size_t count = blocks[word / WORDS_PER_BLOCK];
+    for (size_t w = word - word % WORDS_PER_BLOCK; w < word; w++)
+      count += popcount(words[w]);
+
+    int shift = 63 - int(pos % 64);
+    return count + popcount(words[word] << shift);
+  }
+
+  /**
+   * @brief Position of the k-th one (1-based), or size() if there are fewer ones.
+   */
+  size_t select1(size_t k) const
+  {
+    if (k == 0 || blocks.size() == 0)
+      return bitCount;
+
+    // Find the last block with fewer than k ones before it
+    size_t low = 0, high = blocks.size() - 1;
+    while (low < high)
+    {
+      size_t mid = (low + high + 1) / 2;
+      if (blocks[mid] < k)
+        low = mid;
+      else
+        high = mid - 1;
+    }
+
+    size_t remaining = k - blocks[low];
+    for (size_t w = low * WORDS_PER_BLOCK; w < words.size(); w++)
+    {
+      size_t ones = popcount(words[w]);
+      if (remaining <= ones)
+      {
+        uint64_t word = words[w];
+        for (size_t bit = 0; bit < 64; bit++)
+        {
+          if ((word >> bit) & 1)
+          {
+            if (--remaining == 0)
+              return w * 64 + bit;
+          }
+        }
+      }
+      remaining -= ones;
+    }
+    return bitCount;
+  }
+
+  size_t sizeInBytes() const
+  {
+    return words.size() * sizeof(uint64_t) + blocks.size() * sizeof(uint32_t);
+  }
+
+  const Vector<uint64_t> &getWords() const
+  {
+    return words;
+  }
+
+  void setWords(const Vector<uint64_t> &bits, size_t count)
+  {
+    words = bits;
+    bitCount = count;
+    buildDirectory();
+  }
+};
+
+/**
+ * @class PackedInts
+ * @brief Fixed-width unsigned integers packed back to back in 64-bit words.
+ */
+class PackedInts
+{
+private:
+  Vector<uint64_t> words; // The values, packed
+  int width;              // Bits per value
+  size_t count;           // Number of values
+
+public:
+  PackedInts() : width(1), count(0) {}
+
+  void resize(size_t values, int bitsPerValue)
+  {
+    width = bitsPerValue < 1 ? 1 : bitsPerValue;
+    count = values;
+    words.resize((values * width + 63) / 64 + 1);
+    for (size_t i = 0; i < words.size(); i++)
+      words[i] = 0;
+  }
+
+  void set(size_t i, uint64_t value)
+  {
+    size_t bit = i * width;
+    words[bit / 64] |= value << (bit % 64);
+    if (bit % 64 + width > 64)
+      words[bit / 64 + 1] |= value >> (64 - bit % 64);
+  }
+
+  uint64_t get(size_t i) const
+  {
+    size_t bit = i * width;
+    uint64_t value = words[bit / 64] >> (bit % 64);
+    if (bit % 64 + width > 64)
+      value |= words[bit / 64 + 1] << (64 - bit % 64);
+    return (width == 64) ? value : value & ((uint64_t(1) << width) - 1);
+  }
+
+  size_t size() const
+  {
+    return count;
+  }
+
+  int getWidth() const
+  {
+    return width;
+  }
+
+  size_t sizeInBytes() const
+  {
+    return words.size() * sizeof(uint64_t);
+  }
+
+  const Vector<uint64_t> &getWords() const
+  {
+    return words;
+  }
+
+  void setWords(const Vector<uint64_t> &bits, size_t values, int bitsPerValue)
+  {
+    words = bits;
+    count = values;
+    width = bitsPerValue;
+  }
+};
+
+/**
+ * @class SuccinctTree
+ * @brief A tree stored in about 2 bits per node for the shape, plus its keys.
+ *
+ * Nodes are numbered 1..n in level order (0 means "no node").
+ * Bit 0 of the shape is always set (for the root), and node x owns
+ * bits 2x-1 (has a left child) and 2x (has a right child). The child
+ * behind a set bit at position `pos` is node rank1(pos).
+ */
+class SuccinctTree
+{
+private:
+  RankBits shape;            // Level-order shape bits
+  PackedInts keyOf;          // keyOf[x - 1] = 0-based position of node x's key in the sorted keys
+  std::string keyBlob;       // All keys, in sorted order, back to back
+  Vector<uint32_t> keyStart; // keyStart[k] = offset of key k in keyBlob, plus a final end offset
+  int n;                     // Number of nodes
+
+  static int bitsFor(uint64_t value)
+  {
+    int bits = 1;
+    while (bits < 64 && (value >> bits) != 0)
+      bits++;
+    return bits;
+  }
+
+  std::string_view keyView(size_t k) const
+  {
+    return std::string_view(keyBlob.data() + keyStart[k], keyStart[k + 1] - keyStart[k]);
+  }
+
+  template <typename T>
+  static void writeValue(std::ostream &out, const T &value)
+  {
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  static bool readValue(std::istream &in, T &value)
+  {
+    return bool(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+  }
+
+  static void writeWords(std::ostream &out, const Vector<uint64_t> &words)
+  {
+    uint64_t count = words.size();
+    writeValue(out, count);
+    for (size_t i = 0; i < words.size(); i++)
+      writeValue(out, words[i]);
+  }
+
+  // Bytes left in the stream, or UINT64_MAX if it cannot tell (not seekable)
+  static uint64_t bytesLeft(std::istream &in)
+  {
+    std::streampos here = in.tellg();
+    if (here == std::streampos(-1))
+      return UINT64_MAX;
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.seekg(here);
+    if (end == std::streampos(-1) || end < here)
+      return UINT64_MAX;
+    return uint64_t(end - here);
+  }
+
+  /**
+   * @brief Reads `count` bytes into the buffer that `grow(size)` resizes and returns.
+   *
+   * The size is checked against what is left in the stream first; when that is unknown
+   * the buffer grows as the data actually arrives, so a bad size never allocates it all.
+   */
+  template <typename Grow>
+  static bool readBytes(std::istream &in, uint64_t count, Grow grow)
+  {
+    if (count > bytesLeft(in))
+      return false;
+
+    const uint64_t CHUNK = 1 << 20;
+    for (uint64_t done = 0; done < count;)
+    {
+      uint64_t step = (count - done < CHUNK) ? count - done : CHUNK;
+      char *at = grow(size_t(done + step)) + done;
+      if (!in.read(at, std::streamsize(step)))
+        return false;
+      done += step;
+    }
+    return true;
+  }
+
+  // Reads a word array written by `writeWords`, which must hold exactly `expected` words
+  static bool readWords(std::istream &in, Vector<uint64_t> &words, uint64_t expected)
+  {
+    uint64_t count = 0;
+    if (!readValue(in, count) || count != expected)
+      return false;
+
+    return readBytes(in, count * sizeof(uint64_t), [&words](size_t bytes)
+                     {
+                       words.resize(bytes / sizeof(uint64_t));
+                       return reinterpret_cast<char *>(words.begin()); });
+  }
+
+  /**
+   * @brief Whether `words` hold a valid shape of `count` nodes, so navigation stays in range.
+   *
+   * The 2 * count + 1 bits must hold exactly `count` ones (the root and each child), nothing
+   * may be set past them, and node x must be reached before its own bits: at least x ones
+   * in the bits [0, 2x - 2]. Then every child is numbered after its parent, at most `count`.
+   */
+  static bool validShape(const Vector<uint64_t> &words, size_t count)
+  {
+    size_t bits = 2 * count + 1;
+    auto bit = [&words](size_t pos)
+    { return (words[pos / 64] >> (pos % 64)) & 1; };
+
+    for (size_t pos = bits; pos < words.size() * 64; pos++)
+      if (bit(pos))
+        return false;
+    if (count == 0)
+      return !bit(0);
+
+    size_t ones = 0;
+    for (size_t pos = 0; pos < bits; pos++)
+    {
+      // Bits 2x - 1 and 2x belong to node x, which must already be numbered
+      if (pos > 0 && ones < (pos + 1) / 2)
+        return false;
+      ones += bit(pos);
+    }
+    return ones == count;
+  }
+
+public:
+  SuccinctTree() : n(0) {}
+
+  /**
+   * @brief Encodes a tree. The tree itself is left untouched.
+   */
+  static SuccinctTree encode(const Tree &tree)
+  {
+    SuccinctTree result;
+    const TreeNode *root = tree.getRoot();
+
+    // In-order pass: the keys in sorted order and each node's position among them
+    std::unordered_map<const TreeNode *, uint32_t> position;
+    Vector<const TreeNode *> stack;
+    const TreeNode *node = root;
+    uint32_t next = 0;
+    result.keyStart.push_back(0);
+    while (node || stack.size() > 0)
+    {
+      while (node)
+      {
+        stack.push_back(node);
+        node = node->left;
+      }
+      node = stack.back();
+      stack.pop_back();
+
+      position[node] = next++;
+      result.keyBlob += node->key;
+      result.keyStart.push_back((uint32_t)result.keyBlob.size());
+      node = node->right;
+    }
+
+    // Level-order pass: the shape bits and the node -> key permutation
+    result.n = (int)next;
+    result.shape.resize(2 * size_t(result.n) + 1);
+    result.keyOf.resize(result.n, bitsFor(result.n > 0 ? result.n - 1 : 0));
+    if (root)
+    {
+      result.shape.set(0);
+      Vector<const TreeNode *> queue;
+      queue.push_back(root);
+      for (size_t head = 0; head < queue.size(); head++)
+      {
+        const TreeNode *current = queue[head];
+        size_t x = head + 1;
+        result.keyOf.set(head, position[current]);
+        if (current->left)
+        {
+          result.shape.set(2 * x - 1);
+          queue.push_back(current->left);
+        }
+        if (current->right)
+        {
+          result.shape.set(2 * x);
+          queue.push_back(current->right);
+        }
+      }
+    }
+    result.shape.buildDirectory();
+    return result;
+  }
+
+  /**
+   * @brief Rebuilds a pointer-based tree. Node indices are the 1-based sorted positions.
+   */
+  Tree decode() const
+  {
+    Tree tree;
+    if (n == 0)
+      return tree;
+
+    Vector<TreeNode *> nodes(n + 1);
+    for (int x = 1; x <= n; x++)
+    {
+      size_t k = keyOf.get(x - 1);
+      nodes[x] = new TreeNode(std::string(keyView(k)), int(k) + 1);
+    }
+    for (int x = 1; x <= n; x++)
+    {
+      int left = leftChild(x), right = rightChild(x);
+      nodes[x]->left = left ? nodes[left] : nullptr;
+      nodes[x]->right = right ? nodes[right] : nullptr;
+    }
+    tree.setRoot(nodes[1]);
+    return tree;
+  }
+
+  // === Navigation (nodes are numbered 1..n in level order, 0 = none) ===
+  int root() const
+  {
+    return n > 0 ? 1 : 0;
+  }
+
+  int leftChild(int x) const
+  {
+    size_t pos = 2 * size_t(x) - 1;
+    return shape.get(pos) ? (int)shape.rank1(pos) : 0;
+  }
+
+  int rightChild(int x) const
+  {
+    size_t pos = 2 * size_t(x);
+    return shape.get(pos) ? (int)shape.rank1(pos) : 0;
+  }
+
+  int parent(int x) const
+  {
+    if (x <= 1)
+      return 0;
+    return (int)((shape.select1(x) + 1) / 2);
+  }
+
+  // 1-based position of node x's key in the sorted keys
+  int keyIndex(int x) const
+  {
+    return (int)keyOf.get(x - 1) + 1;
+  }
+
+  std::string label(int x) const
+  {
+    return std::string(keyView(keyOf.get(x - 1)));
+  }
+
+  /**
+   * @brief Searches the encoded tree directly, following the same comparisons as the original tree.
+   *
+   * @return The 1-based position of the key in the sorted keys, or 0 if it is not in the tree.
+   */
+  int find(const std::string &key) const
+  {
+    int x = root();
+    while (x)
+    {
+      size_t k = keyOf.get(x - 1);
+      int cmp = Utils::compareStrings(key, keyView(k));
+      if (cmp == 0)
+        return int(k) + 1;
+      x = (cmp < 0) ? leftChild(x) : rightChild(x);
+    }
+    return 0;
+  }
+
+  int size() const
+  {
+    return n;
+  }
+
+  // Bytes used by the shape bits and their rank directory
+  size_t shapeBytes() const
+  {
+    return shape.sizeInBytes();
+  }
+
+  // Total bytes used by the encoding (shape, permutation and keys)
+  size_t sizeInBytes() const
+  {
+    return shape.sizeInBytes() + keyOf.sizeInBytes() + keyBlob.size() + keyStart.size() * sizeof(uint32_t);
+  }
+
+  /**
+   * @brief Writes the encoding in a binary form that `read` can load back.
+   */
+  void write(std::ostream &out) const
+  {
+    out.write("OBSTSUCC", 8);
+    uint32_t version = 1;
+    writeValue(out, version);
+    int32_t count = n;
+    writeValue(out, count);
+    writeWords(out, shape.getWords());
+    int32_t width = keyOf.getWidth();
+    writeValue(out, width);
+    writeWords(out, keyOf.getWords());
+    uint64_t blobSize = keyBlob.size();
+    writeValue(out, blobSize);
+    out.write(keyBlob.data(), keyBlob.size());
+    for (size_t k = 0; k < keyStart.size(); k++)
+      writeValue(out, keyStart[k]);
+  }
+
+  /**
+   * @brief Loads an encoding written by `write`.
+   *
+   * @return false if the data is not a valid encoding (this object is then left empty).
+   */
+  bool read(std::istream &in)
+  {
+    *this = SuccinctTree();
+    char magic[8];
+    uint32_t version = 0;
+    int32_t count = 0, width = 0;
+    uint64_t blobSize = 0;
+    Vector<uint64_t> shapeWords, keyWords;
+
+    if (!in.read(magic, 8) || std::memcmp(magic, "OBSTSUCC", 8) != 0)
+      return false;
+    if (!readValue(in, version) || version != 1 || !readValue(in, count) || count < 0)
+      return false;
+
+    // Every size must match the node count, and is checked against the stream before allocating
+    size_t nodes = size_t(count);
+    if (!readWords(in, shapeWords, (2 * nodes + 1 + 63) / 64) || !validShape(shapeWords, nodes))
+      return false;
+    if (!readValue(in, width) || width < 1 || width > 64 || !readWords(in, keyWords, (nodes * width + 63) / 64 + 1))
+      return false;
+    if (!readValue(in, blobSize) || blobSize > UINT32_MAX)
+      return false;
+
+    std::string blob;
+    if (!readBytes(in, blobSize, [&blob](size_t bytes)
+                   {
+                     blob.resize(bytes);
+                     return &blob[0]; }))
+      return false;
+
+    // Key offsets run from 0 to the end of the blob without going back
+    if (uint64_t(nodes + 1) * sizeof(uint32_t) > bytesLeft(in))
+      return false;
+    Vector<uint32_t> starts(nodes + 1);
+    for (size_t k = 0; k <= nodes; k++)
+      if (!readValue(in, starts[k]) || (k == 0 ? starts[k] != 0 : starts[k] < starts[k - 1]))
+        return false;
+    if (starts[nodes] != blobSize)
+      return false;
+
+    // Each node maps to its own key
+    PackedInts keys;
+    keys.setWords(keyWords, nodes, width);
+    Vector<bool> seen(nodes);
+    for (size_t x = 0; x < nodes; x++)
+    {
+      uint64_t k = keys.get(x);
+      if (k >= nodes || seen[k])
+        return false;
+      seen[k] = true;
+    }
+
+    n = count;
+    shape.setWords(shapeWords, 2 * nodes + 1);
+    keyOf = keys;
+    keyBlob = std::move(blob);
+    keyStart = starts;
+    return true;
+  }
+};
@@ -0,0 +1,211 @@
+/**
+ * @file TableExport.h
+ * @brief Streams the dynamic programming tables (E, W and Root) to files for offline analysis.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "Vector.h"
+#include "BufferedWriter.h"
+
+/**
+ * @class TableExport
+ * @brief Writes the valid (upper triangular) cells of the tables as CSV or as a binary file.
+ *
+ * The tables computed by `OBST::computeTables` have rows i = 1..n+1 and columns
+ * j = i-1..n; cell (i, j) describes the subtree of keys i..j (empty when j = i-1).
+ * Only those cells are written, row by row, through a large buffer, and a `Window`
+ * can restrict the export to a range of rows and columns.
+ *
+ * CSV: a header line `i,j,e,w,root`, then one line per cell.
+ *
+ * Binary (native byte order):
+ * - Header (48 bytes): "OBSTTBL1", version, n, the window actually written, and the cell count.
+ * - Cells of 12 bytes (float e, float w, int32 root) in the same order as the CSV lines:
+ *   for each row i of the window, columns max(i-1, first column)..last column.
+ */
+class TableExport
+{
+public:
+  static constexpr uint32_t VERSION = 1;
+
+  /**
+   * @struct Window
+   * Rows and columns to export, inclusive. -1 as a last row or column means "to the end".
+   */
+  struct Window
+  {
+    int firstRow;
+    int lastRow;
+    int firstColumn;
+    int lastColumn;
+
+    Window() : firstRow(1), lastRow(-1), firstColumn(0), lastColumn(-1) {}
+  };
+
+private:
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t keyCount;
+    int32_t firstRow;
+    int32_t lastRow;
+    int32_t firstColumn;
+    int32_t lastColumn;
+    uint64_t cellCount;
+    uint64_t reserved;
+  };
+
+  struct Cell
+  {
+    float e;
+    float w;
+    int32_t root;
+  };
+
+  static_assert(sizeof(Header) == 48, "The table header must be 48 bytes");
+  static_assert(sizeof(Cell) == 12, "Table cells must be 12 bytes");
+
+  // Clamps `window` to the tables of n keys; false if the tables do not match each other
+  static bool resolveWindow(const Vector<Vector<float>> &E, const Vector<Vector<float>> &W,
+                            const Vector<Vector<float>> &Root, Window &window, int &n)
+  {
+    if (E.size() < 2 || W.size() != E.size() || Root.size() != E.size())
+    {
+      std::cerr << "The tables are empty or do not match" << std::endl;
+      return false;
+    }
+
+    n = int(E.size()) - 2;
+    if (window.firstRow < 1)
+      window.firstRow = 1;
+    if (window.lastRow < 0 || window.lastRow > n + 1)
+      window.lastRow = n + 1;
+    if (window.firstColumn < 0)
+      window.firstColumn = 0;
+    if (window.lastColumn < 0 || window.lastColumn > n)
+      window.lastColumn = n;
+    return true;
+  }
+
+  // First column written in row i (past `lastColumn` if the row has nothing to write)
+  static int firstColumnOf(const Window &window, int i)
+  {
+    return (window.firstColumn > i - 1) ? window.firstColumn : i - 1;
+  }
+
+  static bool finish(std::ofstream &out, BufferedWriter &writer, const std::string &filename)
+  {
+    writer.flush();
+    out.flush();
+    if (!out.good())
+    {
+      std::cerr << "Failed to write file: " << filename << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+public:
+  /**
+   * @brief Writes the cells of the tables in `window` as CSV lines `i,j,e,w,root`.
+   *
+   * @return true on success; on failure the error is printed.
+   */
+  static bool writeCsv(const std::string &filename, const Vector<Vector<float>> &E, const Vector<Vector<float>> &W,
+                       const Vector<Vector<float>> &Root, Window window = Window())
+  {
+    int n;
+    if (!resolveWindow(E, W, Root, window, n))
+      return false;
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+      std::cerr << "Failed to open file: " << filename << std::endl;
+      return false;
+    }
+
+    BufferedWriter writer(out);
+    writer.put("i,j,e,w,root\n");
+
+    for (int i = window.firstRow; i <= window.lastRow; i++)
+    {
+      const Vector<float> &e = E[i], &w = W[i], &root = Root[i];
+      for (int j = firstColumnOf(window, i); j <= window.lastColumn; j++)
+      {
+        writer.putNumber(i);
+        writer.put(',');
+        writer.putNumber(j);
+        writer.put(',');
+        writer.putNumber(e[j]);
+        writer.put(',');
+        writer.putNumber(w[j]);
+        writer.put(',');
+        writer.putNumber(int(root[j]));
+        writer.put('\n');
+      }
+    }
+
+    return finish(out, writer, filename);
+  }
+
+  /**
+   * @brief Writes the cells of the tables in `window` in the binary format above.
+   *
+   * @return true on success; on failure the error is printed.
+   */
+  static bool writeBinary(const std::string &filename, const Vector<Vector<float>> &E, const Vector<Vector<float>> &W,
+                          const Vector<Vector<float>> &Root, Window window = Window())
+  {
+    int n;
+    if (!resolveWindow(E, W, Root, window, n))
+      return false;
+
+    uint64_t cellCount = 0;
+    for (int i = window.firstRow; i <= window.lastRow; i++)
+    {
+      int first = firstColumnOf(window, i);
+      if (first <= window.lastColumn)
+        cellCount += uint64_t(window.lastColumn - first + 1);
+    }
+
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+      std::cerr << "Failed to open file: " << filename << std::endl;
+      return false;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, "OBSTTBL1", 8);
+    header.version = VERSION;
+    header.keyCount = uint32_t(n);
+    header.firstRow = window.firstRow;
+    header.lastRow = window.lastRow;
+    header.firstColumn = window.firstColumn;
+    header.lastColumn = window.lastColumn;
+    header.cellCount = cellCount;
+
+    BufferedWriter writer(out);
+    writer.putValue(header);
+
+    for (int i = window.firstRow; i <= window.lastRow; i++)
+    {
+      const Vector<float> &e = E[i], &w = W[i], &root = Root[i];
+      for (int j = firstColumnOf(window, i); j <= window.lastColumn; j++)
+      {
+        Cell cell = {e[j], w[j], int32_t(root[j])};
+        writer.putValue(cell);
+      }
+    }
+
+    return finish(out, writer, filename);
+  }
+};
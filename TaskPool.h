@@ -0,0 +1,307 @@
+/**
+ * This file contains a small work-stealing thread pool used to run independent
+ * pieces of work (like building the two subtrees of a node) on all cores.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @class TaskPool
+ * @brief A fixed set of worker threads, each with its own task queue.
+ *
+ * A worker runs the newest task of its own queue first (good locality for tasks
+ * that split themselves), and when its queue is empty it steals the oldest task
+ * of another worker (the biggest remaining piece of work).
+ */
+class TaskPool
+{
+private:
+  struct Queue
+  {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<bool> stopping;
+  std::atomic<int> queued;          // Number of tasks waiting in all the queues
+  std::atomic<unsigned> nextQueue;  // Round-robin target for tasks submitted from outside the pool
+  std::mutex sleepLock;
+  std::condition_variable wakeUp;
+
+  // The pool and queue index of the calling thread, if it is one of the workers
+  static const TaskPool *&currentPool()
+  {
+    static thread_local const TaskPool *pool = nullptr;
+    return pool;
+  }
+
+  static int &currentIndex()
+  {
+    static thread_local int index = -1;
+    return index;
+  }
+
+  int selfIndex() const
+  {
+    return currentPool() == this ? currentIndex() : -1;
+  }
+
+  bool popFrom(int index, bool newest, std::function<void()> &task)
+  {
+    Queue &queue = *queues[index];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.tasks.empty())
+      return false;
+
+    if (newest)
+    {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+    else
+    {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Takes a task from the own queue, or steals one from the others
+  bool takeTask(int self, std::function<void()> &task)
+  {
+    if (self >= 0 && popFrom(self, true, task))
+      return true;
+
+    int count = (int)queues.size();
+    int start = (self >= 0) ? self + 1 : 0;
+    for (int k = 0; k < count; k++)
+    {
+      int victim = (start + k) % count;
+      if (victim != self && popFrom(victim, false, task))
+        return true;
+    }
+    return false;
+  }
+
+  void workerLoop(int self)
+  {
+    currentPool() = this;
+    currentIndex() = self;
+
+    std::function<void()> task;
+    while (true)
+    {
+      if (takeTask(self, task))
+      {
+        task();
+        task = nullptr;
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(sleepLock);
+      wakeUp.wait(lock, [this]
+                  { return stopping.load() || queued.load() > 0; });
+      if (stopping.load() && queued.load() == 0)
+        return;
+    }
+  }
+
+public:
+  /**
+   * @brief Starts the worker threads.
+   *
+   * @param threads Number of workers (default: one per hardware thread).
+   */
+  explicit TaskPool(unsigned threads = std::thread::hardware_concurrency())
+      : stopping(false), queued(0), nextQueue(0)
+  {
+    if (threads == 0)
+      threads = 1;
+
+    for (unsigned i = 0; i < threads; i++)
+      queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    for (unsigned i = 0; i < threads; i++)
+      workers.emplace_back(&TaskPool::workerLoop, this, (int)i);
+  }
+
+  /**
+   * @brief Runs the remaining tasks and stops the workers.
+   */
+  ~TaskPool()
+  {
+    {
+      std::lock_guard<std::mutex> guard(sleepLock);
+      stopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread &worker : workers)
+      worker.join();
+  }
+
+  TaskPool(const TaskPool &) = delete;
+  TaskPool &operator=(const TaskPool &) = delete;
+
+  /**
+   * @brief Queues a task. Tasks submitted by a worker go to its own queue.
+   */
+  void submit(std::function<void()> task)
+  {
+    int self = selfIndex();
+    int index = (self >= 0) ? self : (int)(nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size());
+    {
+      std::lock_guard<std::mutex> guard(queues[index]->lock);
+      queues[index]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1, std::memory_order_relaxed);
+
+    {
+      std::lock_guard<std::mutex> guard(sleepLock);
+    }
+    wakeUp.notify_one();
+  }
+
+  /**
+   * @brief Runs one waiting task on the calling thread, if there is any.
+   *
+   * Used while waiting for tasks, so a waiting worker keeps helping instead of blocking.
+   *
+   * @return true if a task was run.
+   */
+  bool runPending()
+  {
+    std::function<void()> task;
+    if (!takeTask(selfIndex(), task))
+      return false;
+    task();
+    return true;
+  }
+
+  unsigned size() const
+  {
+    return (unsigned)workers.size();
+  }
+
+  /**
+   * @brief A pool shared by the whole program, started on first use.
+   */
+  static TaskPool &shared()
+  {
+    static TaskPool pool;
+    return pool;
+  }
+};
+
+/**
+ * @class TaskGroup
+ * @brief Tracks a set of tasks submitted to a pool so the caller can wait for all of them.
+ *
+ * If a task throws, the rest of the group still runs and `wait` rethrows the first exception.
+ */
+class TaskGroup
+{
+private:
+  TaskPool &pool;
+  std::atomic<int> pending;
+  std::mutex doneLock;
+  std::condition_variable done;
+  std::exception_ptr error; // First exception thrown by a task (guarded by doneLock)
+
+  // Marks one task done, waking the waiters when it was the last one
+  void finishOne()
+  {
+    // Under the lock, so the group cannot be destroyed before the notification is sent
+    std::lock_guard<std::mutex> guard(doneLock);
+    if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      done.notify_all();
+  }
+
+  // Waits for every task, helping with queued tasks and sleeping when there are none
+  void drain()
+  {
+    while (pending.load(std::memory_order_acquire) > 0)
+    {
+      if (pool.runPending())
+        continue;
+
+      // The remaining tasks are running elsewhere; wake up now and then in case they queue more
+      std::unique_lock<std::mutex> lock(doneLock);
+      done.wait_for(lock, std::chrono::milliseconds(1), [this]
+                    { return pending.load(std::memory_order_acquire) == 0; });
+    }
+
+    // The last task may still be notifying, let it release the lock
+    std::lock_guard<std::mutex> guard(doneLock);
+  }
+
+public:
+  explicit TaskGroup(TaskPool &pool) : pool(pool), pending(0) {}
+
+  // Waits for the tasks; an exception not collected by `wait` is dropped
+  ~TaskGroup()
+  {
+    drain();
+  }
+
+  TaskGroup(const TaskGroup &) = delete;
+  TaskGroup &operator=(const TaskGroup &) = delete;
+
+  /**
+   * @brief Submits a task belonging to this group. Tasks may add more tasks to the group.
+   */
+  void run(std::function<void()> task)
+  {
+    pending.fetch_add(1, std::memory_order_relaxed);
+    pool.submit([this, task]
+                {
+                  // Counts the task as done however it ends
+                  struct Finish
+                  {
+                    TaskGroup *group;
+                    ~Finish() { group->finishOne(); }
+                  } finish{this};
+
+                  try
+                  {
+                    task();
+                  }
+                  catch (...)
+                  {
+                    std::lock_guard<std::mutex> guard(doneLock);
+                    if (!error)
+                      error = std::current_exception();
+                  } });
+  }
+
+  /**
+   * @brief Waits until every task of the group is done, running queued tasks meanwhile.
+   *
+   * @throws The first exception thrown by a task of the group, if any.
+   */
+  void wait()
+  {
+    drain();
+
+    std::exception_ptr thrown;
+    {
+      std::lock_guard<std::mutex> guard(doneLock);
+      std::swap(thrown, error);
+    }
+    if (thrown)
+      std::rethrow_exception(thrown);
+  }
+};
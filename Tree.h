@@ -2,112 +2,343 @@
 
 #include <iostream>
 #include <iomanip>
+#include <atomic>
+#include <string>
 #include "TreeNode.h"
+#include "Vector.h"
+#include "Utils.h"
+
+/**
+ * @struct TreeStats
+ * Holds the statistics of a tree, all gathered in a single traversal.
+ * The weighted fields are only meaningful when the nodes carry probabilities.
+ */
+struct TreeStats
+{
+  int height = 0;              // Number of levels in the tree
+  int totalNodes = 0;          // Number of nodes in the tree
+  int leafNodes = 0;           // Number of nodes without children
+  long long sumOfDepths = 0;   // Sum of the depths of all nodes (root has depth 0)
+  double averageDepth = 0;     // sumOfDepths / totalNodes
+  bool hasWeights = false;     // Whether the probabilities p (and q) are known
+  double keyWeight = 0;        // Sum of p over all nodes
+  double totalWeight = 0;      // Sum of all p and q in the tree
+  double weightedDepthSum = 0; // Sum of p * depth over all nodes
+  double expectedCost = 0;     // Weighted search cost, misses charged at the dummy leaf (E[1][n] of the DP)
+};
+
+/**
+ * @struct LookupResult
+ * The answer to a search: the node holding the key, or the gap the key falls in.
+ */
+struct LookupResult
+{
+  const TreeNode *node = nullptr; // The node holding the key, null if the key is not in the tree
+  int gap = -1;                   // On a miss, the index in q of the gap the key falls in (-1 on a hit or if unknown)
+};
+
+/**
+ * @struct TreeData
+ * The nodes of a tree and the data that goes with them, shared by every
+ * `Tree` copy and freed when the last one lets go of it.
+ */
+struct TreeData
+{
+  std::atomic<int> refs;           // Number of `Tree` objects sharing this data
+  TreeNode *root;                  // Pointer to the root of the tree
+  Vector<float> gapWeights;        // Probabilities of un-successful search (q), empty if unknown
+  std::atomic<TreeStats *> stats;  // Statistics of these nodes, computed on first use (null until then)
+
+  TreeData(TreeNode *root, const Vector<float> &gapWeights) : refs(1), root(root), gapWeights(gapWeights), stats(nullptr) {}
+
+  ~TreeData()
+  {
+    delete stats.load(std::memory_order_acquire);
+  }
+};
 
 /**
  * @class Tree
  * A class to represent a binary tree and provide utilities like displaying
  * the tree structure, cleaning up memory, and analyzing the tree.
+ *
+ * Copies share the same nodes (copy-on-write): copying or assigning a tree is O(1),
+ * and the nodes are only duplicated when a shared tree is about to be modified.
  */
 class Tree
 {
 private:
-  TreeNode *root; // Pointer to the root of the tree
+  TreeData *data; // Shared nodes, null for an empty tree
+
+  // Stack frames used by the iterative traversals
+  struct DepthFrame
+  {
+    const TreeNode *node;
+    int depth;
+  };
+
+  struct CopyFrame
+  {
+    const TreeNode *source;
+    TreeNode *copy;
+  };
 
   // === Your Existing Helper Methods ===
-  void displayTreeHelper(TreeNode *node, int depth = 0) const
+  // Prints the tree sideways (right subtree on top) with an explicit stack instead of recursion
+  void displayTreeHelper(const TreeNode *node) const
   {
-    if (!node)
-      return;
+    Vector<DepthFrame> stack;
+    int depth = 0;
+
+    while (node || stack.size() > 0)
+    {
+      // Go down the right spine first, the rightmost node is printed first
+      while (node)
+      {
+        stack.push_back({node, depth});
+        node = node->right;
+        depth++;
+      }
+
+      DepthFrame top = stack.back();
+      stack.pop_back();
 
-    displayTreeHelper(node->right, depth + 1);
-    for (int i = 0; i < 2 * depth; ++i)
-      std::cout << " ";
-    std::cout << node->key << std::endl;
-    displayTreeHelper(node->left, depth + 1);
+      for (int i = 0; i < 2 * top.depth; ++i)
+        std::cout << " ";
+      std::cout << top.node->key << std::endl;
+
+      node = top.node->left;
+      depth = top.depth + 1;
+    }
   }
 
+  // Frees the tree without any stack: left children are rotated up until the node has none, then it is deleted
   void deleteTree(TreeNode *node)
   {
-    if (!node)
-      return;
-
-    deleteTree(node->left);
-    deleteTree(node->right);
-    delete node;
+    while (node)
+    {
+      if (node->left)
+      {
+        TreeNode *left = node->left;
+        node->left = left->right;
+        left->right = node;
+        node = left;
+      }
+      else
+      {
+        TreeNode *right = node->right;
+        delete node;
+        node = right;
+      }
+    }
   }
 
-  TreeNode *copySubtree(TreeNode *node) const
+  TreeNode *copySubtree(const TreeNode *node) const
   {
     if (!node)
       return nullptr;
 
-    TreeNode *newNode = new TreeNode(node->key);
-    newNode->left = copySubtree(node->left);
-    newNode->right = copySubtree(node->right);
-    return newNode;
+    TreeNode *rootCopy = new TreeNode(node->key, node->index, node->p);
+    Vector<CopyFrame> stack;
+    stack.push_back({node, rootCopy});
+
+    while (stack.size() > 0)
+    {
+      CopyFrame top = stack.back();
+      stack.pop_back();
+
+      if (top.source->left)
+      {
+        const TreeNode *left = top.source->left;
+        top.copy->left = new TreeNode(left->key, left->index, left->p);
+        stack.push_back({left, top.copy->left});
+      }
+      if (top.source->right)
+      {
+        const TreeNode *right = top.source->right;
+        top.copy->right = new TreeNode(right->key, right->index, right->p);
+        stack.push_back({right, top.copy->right});
+      }
+    }
+
+    return rootCopy;
   }
 
   // === Analysis Helper Methods ===
-  int computeHeight(TreeNode *node) const
+  float gapWeight(int gap) const
   {
-    if (!node)
-      return 0;
-    int leftHeight = computeHeight(node->left);
-    int rightHeight = computeHeight(node->right);
-    return 1 + (leftHeight > rightHeight ? leftHeight : rightHeight);
+    return (data && gap >= 0 && gap < (int)data->gapWeights.size()) ? data->gapWeights[gap] : 0;
   }
 
-  int countNodes(TreeNode *node) const
+  // Collects every statistic in a single traversal (explicit stack) and returns the height of the tree
+  int collectStats(const TreeNode *node, TreeStats &out) const
   {
     if (!node)
       return 0;
-    return 1 + countNodes(node->left) + countNodes(node->right);
+
+    int height = 0;
+    Vector<DepthFrame> stack;
+    stack.push_back({node, 0});
+
+    while (stack.size() > 0)
+    {
+      DepthFrame top = stack.back();
+      stack.pop_back();
+      node = top.node;
+      int depth = top.depth;
+
+      if (depth + 1 > height)
+        height = depth + 1;
+
+      out.totalNodes++;
+      out.sumOfDepths += depth;
+      if (!node->left && !node->right)
+        out.leafNodes++;
+
+      // A search for this key costs (depth + 1) comparisons
+      out.keyWeight += node->p;
+      out.totalWeight += node->p;
+      out.weightedDepthSum += node->p * depth;
+      out.expectedCost += node->p * (depth + 1);
+
+      // An unsuccessful search ends at a dummy leaf one level below this node, which costs
+      // (depth + 2) as in the DP, so the cost can be compared with E[1][n]
+      if (node->index > 0)
+      {
+        if (!node->left)
+        {
+          out.totalWeight += gapWeight(node->index - 1);
+          out.expectedCost += gapWeight(node->index - 1) * (depth + 2);
+        }
+        if (!node->right)
+        {
+          out.totalWeight += gapWeight(node->index);
+          out.expectedCost += gapWeight(node->index) * (depth + 2);
+        }
+      }
+
+      if (node->right)
+        stack.push_back({node->right, depth + 1});
+      if (node->left)
+        stack.push_back({node->left, depth + 1});
+    }
+
+    return height;
   }
 
-  int countLeafNodes(TreeNode *node) const
+  // Drops the cached statistics; only called once `data` is not shared with any other tree
+  void invalidateStats()
   {
-    if (!node)
-      return 0;
-    if (!node->left && !node->right)
-      return 1;
-    return countLeafNodes(node->left) + countLeafNodes(node->right);
+    if (data)
+      delete data->stats.exchange(nullptr, std::memory_order_acq_rel);
   }
 
-  int sumOfDepths(TreeNode *node, int depth) const
+  // Hints the CPU to start loading a node we will visit soon
+  static void prefetch(const void *address)
   {
-    if (!node)
-      return 0;
-    return depth + sumOfDepths(node->left, depth + 1) + sumOfDepths(node->right, depth + 1);
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+  }
+
+  // The gap a missing key falls in, given the last node visited and the side it would go to
+  static int gapOf(const TreeNode *last, bool wentLeft)
+  {
+    if (!last || last->index <= 0)
+      return -1;
+    return wentLeft ? last->index - 1 : last->index;
+  }
+
+  // A node and the part [begin, end) of a sorted batch that reaches it, used by `findSorted`
+  struct SortedFrame
+  {
+    const TreeNode *node;
+    size_t begin, end;
+  };
+
+  // First position in [begin, end) whose key is not less than (or, if `orEqual`, greater than) `key`
+  static size_t boundOf(const Vector<std::string> &keys, size_t begin, size_t end, const std::string &key, bool orEqual)
+  {
+    while (begin < end)
+    {
+      size_t mid = begin + (end - begin) / 2;
+      int cmp = Utils::compareStrings(keys[mid], key);
+      if (cmp < 0 || (orEqual && cmp == 0))
+        begin = mid + 1;
+      else
+        end = mid;
+    }
+    return begin;
+  }
+
+  // A key in flight in `findBatch`
+  struct BatchCursor
+  {
+    const TreeNode *node; // The next node to compare against
+    int key;              // Position of the key in the batch
+  };
+
+  // Lets go of the shared data, freeing the nodes if this was the last copy using them
+  void release()
+  {
+    if (data && data->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      deleteTree(data->root);
+      delete data;
+    }
+    data = nullptr;
+  }
+
+  // Makes sure this tree is the only one using its data, copying the nodes if they are shared
+  void detach()
+  {
+    if (!data)
+    {
+      data = new TreeData(nullptr, Vector<float>());
+    }
+    else if (data->refs.load(std::memory_order_acquire) > 1)
+    {
+      TreeData *copy = new TreeData(copySubtree(data->root), data->gapWeights);
+      release();
+      data = copy;
+    }
   }
 
 public:
   // === Your Existing Methods ===
-  Tree() : root(nullptr) {}
+  Tree() : data(nullptr) {}
 
   ~Tree()
   {
-    deleteTree(root);
+    release();
   }
 
-  // Copy constructor
-  Tree(const Tree &other) : root(copySubtree(other.root)) {}
+  // Copy constructor, shares the nodes of the other tree
+  Tree(const Tree &other) : data(other.data)
+  {
+    if (data)
+      data->refs.fetch_add(1, std::memory_order_relaxed);
+  }
 
-  // Copy assignment operator
+  // Copy assignment operator, shares the nodes of the other tree
   Tree &operator=(const Tree &other)
   {
-    if (this != &other)
+    if (this != &other && data != other.data)
     {
-      deleteTree(root);
-      root = copySubtree(other.root);
+      if (other.data)
+        other.data->refs.fetch_add(1, std::memory_order_relaxed);
+      release();
+      data = other.data;
     }
     return *this;
   }
 
   // Move constructor
-  Tree(Tree &&other) noexcept : root(other.root)
+  Tree(Tree &&other) noexcept : data(other.data)
   {
-    other.root = nullptr;
+    other.data = nullptr;
   }
 
   // Move assignment operator
@@ -115,70 +346,453 @@ public:
   {
     if (this != &other)
     {
-      deleteTree(root);
-      root = other.root;
-      other.root = nullptr;
+      release();
+      data = other.data;
+      other.data = nullptr;
     }
     return *this;
   }
 
+  /**
+   * @brief Makes `node` the root of this tree, which takes ownership of it.
+   *
+   * Other copies sharing the previous nodes keep them unchanged.
+   */
   void setRoot(TreeNode *node)
   {
-    root = node;
+    if (data && data->refs.load(std::memory_order_acquire) > 1)
+    {
+      TreeData *fresh = new TreeData(node, data->gapWeights);
+      release();
+      data = fresh;
+    }
+    else
+    {
+      detach();
+      data->root = node;
+    }
+    invalidateStats();
+  }
+
+  /**
+   * @brief Sets the probabilities of un-successful search (q) used by the weighted statistics.
+   *
+   * q[k] is the probability of searching for a value between the k-th and (k+1)-th labels,
+   * in the same layout `OBST::generateTheOBST` expects.
+   */
+  void setGapWeights(const Vector<float> &q)
+  {
+    detach();
+    data->gapWeights = q;
+    invalidateStats();
+  }
+
+  const TreeNode *getRoot() const
+  {
+    return data ? data->root : nullptr;
+  }
+
+  /**
+   * @brief Returns the root for in-place modification.
+   *
+   * If the nodes are shared with other copies they are duplicated first,
+   * so the changes are only seen by this tree. The cached statistics are dropped.
+   */
+  TreeNode *getMutableRoot()
+  {
+    detach();
+    invalidateStats();
+    return data->root;
+  }
+
+  const Vector<float> &getGapWeights() const
+  {
+    static const Vector<float> none;
+    return data ? data->gapWeights : none;
   }
 
-  TreeNode *getRoot() const
+  // Number of trees sharing these nodes (0 for an empty tree)
+  int useCount() const
   {
-    return root;
+    return data ? data->refs.load(std::memory_order_relaxed) : 0;
   }
 
   void displayTree() const
   {
-    displayTreeHelper(root);
+    displayTreeHelper(data ? data->root : nullptr);
   }
 
   void assign(const Tree &otherTree)
   {
-    *this = otherTree; // Use copy assignment operator
+    *this = otherTree; // Use copy assignment operator (shares the nodes)
   }
 
   // === New Analysis Methods ===
+
+  /**
+   * @brief Returns the statistics of the tree.
+   *
+   * Every statistic is computed in a single traversal and cached with the shared nodes until
+   * the tree changes, so all copies of a tree reuse one result. Safe to call from many
+   * threads on the same tree: if two compute it at once, one result is kept and the other
+   * dropped.
+   */
+  const TreeStats &getStats() const
+  {
+    static const TreeStats empty;
+    if (!data)
+      return empty;
+
+    TreeStats *cached = data->stats.load(std::memory_order_acquire);
+    if (!cached)
+    {
+      TreeStats *fresh = new TreeStats();
+      fresh->height = collectStats(getRoot(), *fresh);
+      fresh->averageDepth = (fresh->totalNodes == 0) ? 0.0 : static_cast<double>(fresh->sumOfDepths) / fresh->totalNodes;
+      fresh->hasWeights = fresh->totalWeight > 0;
+
+      if (data->stats.compare_exchange_strong(cached, fresh, std::memory_order_acq_rel, std::memory_order_acquire))
+        cached = fresh;
+      else
+        delete fresh; // Another reader published its result first
+    }
+    return *cached;
+  }
+
   void analyzeTree() const
   {
-    int height = computeHeight(root);
-    int totalNodes = countNodes(root);
-    int leafNodes = countLeafNodes(root);
-    double averageDepth = (totalNodes == 0) ? 0.0 : static_cast<double>(sumOfDepths(root, 0)) / totalNodes;
+    const TreeStats &s = getStats();
+
+    std::cout << "Height of the Tree: " << s.height << std::endl;
+    std::cout << "Total Number of Nodes: " << s.totalNodes << std::endl;
+    std::cout << "Number of Leaf Nodes: " << s.leafNodes << std::endl;
+    std::cout << "Average Depth of Nodes: " << s.averageDepth << std::endl;
 
-    std::cout << "Height of the Tree: " << height << std::endl;
-    std::cout << "Total Number of Nodes: " << totalNodes << std::endl;
-    std::cout << "Number of Leaf Nodes: " << leafNodes << std::endl;
-    std::cout << "Average Depth of Nodes: " << averageDepth << std::endl;
+    if (s.hasWeights)
+    {
+      std::cout << "Weighted Average Depth: " << getWeightedDepth() << std::endl;
+      std::cout << "Expected Search Cost: " << s.expectedCost << std::endl;
+    }
   }
 
   int getHeight() const
   {
-    return computeHeight(root);
+    return getStats().height;
   }
 
   int getTotalNodes() const
   {
-    return countNodes(root);
+    return getStats().totalNodes;
   }
 
   int getLeafNodes() const
   {
-    return countLeafNodes(root);
+    return getStats().leafNodes;
   }
 
   double getAverageDepth() const
   {
-    int totalNodes = countNodes(root);
-    return (totalNodes == 0) ? 0.0 : static_cast<double>(sumOfDepths(root, 0)) / totalNodes;
+    return getStats().averageDepth;
+  }
+
+  // Average depth of the keys weighted by their probabilities p (0 if unknown)
+  double getWeightedDepth() const
+  {
+    const TreeStats &s = getStats();
+    return (s.keyWeight == 0) ? 0.0 : s.weightedDepthSum / s.keyWeight;
+  }
+
+  // Expected search cost weighted by p and q, misses charged at the dummy leaf as in the DP (0 if unknown)
+  double getExpectedCost() const
+  {
+    return getStats().expectedCost;
+  }
+
+  // === Search Methods ===
+
+  /**
+   * @brief Searches for a key, using the same ordering as `Utils::compareStrings`.
+   */
+  LookupResult find(const std::string &key) const
+  {
+    LookupResult result;
+    const TreeNode *node = getRoot();
+    const TreeNode *last = nullptr;
+    bool wentLeft = false;
+
+    while (node)
+    {
+      int cmp = Utils::compareStrings(key, node->key);
+      if (cmp == 0)
+      {
+        result.node = node;
+        return result;
+      }
+      last = node;
+      wentLeft = cmp < 0;
+      node = wentLeft ? node->left : node->right;
+    }
+
+    result.gap = gapOf(last, wentLeft);
+    return result;
+  }
+
+  /**
+   * @brief Searches for many keys at once, hiding the memory latency of each level.
+   *
+   * All keys go down the tree in lockstep: each one takes a single step, the node
+   * it needs next is prefetched, and the other keys take their step while that
+   * node is being loaded. The results are the same as calling `find` for each key.
+   *
+   * @param keys The keys to search for.
+   * @param results Resized to keys.size(), results[i] answers keys[i].
+   */
+  void findBatch(const Vector<std::string> &keys, Vector<LookupResult> &results) const
+  {
+    size_t count = keys.size();
+    results.resize(count);
+
+    const TreeNode *root = getRoot();
+    if (root)
+      prefetch(root);
+
+    // Every key starts at the root; finished keys are swapped out of the active part
+    Vector<BatchCursor> cursors(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      cursors[i] = {root, (int)i};
+      results[i] = LookupResult();
+    }
+
+    size_t active = root ? count : 0;
+
+    while (active > 0)
+    {
+      size_t i = 0;
+      while (i < active)
+      {
+        BatchCursor &cursor = cursors[i];
+        const TreeNode *node = cursor.node;
+        int cmp = Utils::compareStrings(keys[cursor.key], node->key);
+
+        const TreeNode *next = nullptr;
+        if (cmp == 0)
+          results[cursor.key].node = node;
+        else
+        {
+          next = (cmp < 0) ? node->left : node->right;
+          if (!next)
+            results[cursor.key].gap = gapOf(node, cmp < 0);
+        }
+
+        if (next)
+        {
+          prefetch(next);
+          cursor.node = next;
+          i++;
+        }
+        else
+        {
+          // This key is done, replace it with the last active one
+          cursor = cursors[--active];
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief Searches for a batch of sorted keys, visiting each node at most once.
+   *
+   * The batch is split at every node: the keys before `node->key` go down the left
+   * child and the rest go down the right one, so the keys sharing a path share its
+   * comparisons. The results are the same as calling `find` for each key.
+   *
+   * @param sortedKeys The keys, sorted with the `Utils::compareStrings` ordering.
+   * @param results Resized to sortedKeys.size(), results[i] answers sortedKeys[i].
+   */
+  void findSorted(const Vector<std::string> &sortedKeys, Vector<LookupResult> &results) const
+  {
+    size_t count = sortedKeys.size();
+    results.resize(count);
+    for (size_t i = 0; i < count; i++)
+      results[i] = LookupResult();
+
+    const TreeNode *root = getRoot();
+    if (!root || count == 0)
+      return;
+
+    Vector<SortedFrame> stack;
+    stack.push_back({root, 0, count});
+
+    while (stack.size() > 0)
+    {
+      SortedFrame frame = stack.back();
+      stack.pop_back();
+      const TreeNode *node = frame.node;
+
+      // [begin, lower) goes left, [lower, upper) is this key, [upper, end) goes right
+      size_t lower = boundOf(sortedKeys, frame.begin, frame.end, node->key, false);
+      size_t upper = boundOf(sortedKeys, lower, frame.end, node->key, true);
+
+      for (size_t i = lower; i < upper; i++)
+        results[i].node = node;
+
+      if (frame.begin < lower)
+      {
+        if (node->left)
+          stack.push_back({node->left, frame.begin, lower});
+        else
+          for (size_t i = frame.begin; i < lower; i++)
+            results[i].gap = gapOf(node, true);
+      }
+
+      if (upper < frame.end)
+      {
+        if (node->right)
+          stack.push_back({node->right, upper, frame.end});
+        else
+          for (size_t i = upper; i < frame.end; i++)
+            results[i].gap = gapOf(node, false);
+      }
+    }
+  }
+
+  // === Iteration Methods ===
+
+  /**
+   * @class Iterator
+   * Walks the keys in order (the `Utils::compareStrings` ordering) with an explicit stack
+   * of the ancestors still to be visited, so it holds at most `getHeight()` pointers.
+   * The nodes it returns stay valid while the tree they came from is not modified.
+   */
+  class Iterator
+  {
+  private:
+    Vector<const TreeNode *> stack; // The top is the current node, the rest are ancestors still to visit
+    std::string upper;              // Last key to visit when `bounded`
+    bool bounded;
+
+    // Pushes `node` and its left spine, the leftmost node ends up on top
+    void pushLeft(const TreeNode *node)
+    {
+      while (node)
+      {
+        stack.push_back(node);
+        node = node->left;
+      }
+    }
+
+    // Stops the walk once the current key is past the upper bound
+    void checkBound()
+    {
+      if (bounded && stack.size() > 0 &&
+          Utils::compareStrings(stack.back()->key, upper) > 0)
+        stack = Vector<const TreeNode *>();
+    }
+
+    friend class Tree;
+
+  public:
+    Iterator() : bounded(false) {}
+
+    const TreeNode &operator*() const
+    {
+      return *stack.back();
+    }
+
+    const TreeNode *operator->() const
+    {
+      return stack.back();
+    }
+
+    Iterator &operator++()
+    {
+      const TreeNode *node = stack.back();
+      stack.pop_back();
+      pushLeft(node->right);
+      checkBound();
+      return *this;
+    }
+
+    // Two iterators are equal when they are both done or stand on the same node
+    bool operator==(const Iterator &other) const
+    {
+      if (stack.size() == 0 || other.stack.size() == 0)
+        return stack.size() == other.stack.size();
+      return stack.back() == other.stack.back();
+    }
+
+    bool operator!=(const Iterator &other) const
+    {
+      return !(*this == other);
+    }
+  };
+
+  /**
+   * @struct Range
+   * The keys between two bounds, usable in a range-based for loop.
+   */
+  struct Range
+  {
+    Iterator first;
+
+    Iterator begin() const
+    {
+      return first;
+    }
+
+    Iterator end() const
+    {
+      return Iterator();
+    }
+  };
+
+  // Iterator on the smallest key
+  Iterator begin() const
+  {
+    Iterator it;
+    it.pushLeft(getRoot());
+    return it;
+  }
+
+  Iterator end() const
+  {
+    return Iterator();
+  }
+
+  /**
+   * @brief Returns the keys k with lo <= k <= hi, in order.
+   *
+   * Only the path to `lo` is walked before the first key, then each step is amortized O(1),
+   * so scanning m keys costs O(height + m) without copying the labels out.
+   */
+  Range range(const std::string &lo, const std::string &hi) const
+  {
+    Range result;
+    Iterator &it = result.first;
+    it.upper = hi;
+    it.bounded = true;
+
+    // Keep the nodes not less than `lo` on the way down, the last one kept is the first key in range
+    const TreeNode *node = getRoot();
+    while (node)
+    {
+      if (Utils::compareStrings(node->key, lo) >= 0)
+      {
+        it.stack.push_back(node);
+        node = node->left;
+      }
+      else
+      {
+        node = node->right;
+      }
+    }
+    it.checkBound();
+    return result;
   }
 
   bool isEmpty() const
   {
-    return root == nullptr;
+    return getRoot() == nullptr;
   }
 };
\ No newline at end of file
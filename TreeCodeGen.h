@@ -0,0 +1,350 @@
+/**
+ * @file TreeCodeGen.h
+ * @brief Compiles a built tree into a C++ search function with its shape and probabilities baked in.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include "TreeNode.h"
+#include "Vector.h"
+#include "Tree.h"
+#include "Utils.h"
+
+/**
+ * @class TreeCodeGen
+ * @brief Writes a header with a search function that follows the comparisons of a tree.
+ *
+ * The generated function is a flat list of `goto` targets, one per node, so its size and
+ * nesting do not depend on the height of the tree. It orders keys like `Utils::compareStrings`:
+ * numeric keys are parsed once and compared to numeric labels as integers. A branch carries a
+ * likelihood hint when the probabilities p and q stored in the tree make it clearly lopsided.
+ *
+ * The function returns the 1-based rank of the key among the labels, or 0 if the key is
+ * not there, in which case `*gap` (if given) is set to the index in q of its gap.
+ */
+class TreeCodeGen
+{
+private:
+  // A node to emit and the range of ranks [lo, hi] its subtree covers
+  struct CodeFrame
+  {
+    const TreeNode *node;
+    int lo, hi;
+  };
+
+  // Largest number of significant digits compiled as an integer compare (fits in uint64_t)
+  static constexpr size_t MAX_INT_DIGITS = 18;
+
+  // Share of the searches reaching a test above which it is hinted as likely
+  static constexpr double LIKELY_SHARE = 0.9;
+
+  // The label's value if it is numeric and short enough for an integer compare
+  bool static integerLabel(const std::string &label, unsigned long long &value)
+  {
+    if (!Utils::isNumeric(label))
+      return false;
+
+    size_t start = 0;
+    while (start + 1 < label.size() && label[start] == '0')
+      start++;
+    if (label.size() - start > MAX_INT_DIGITS)
+      return false;
+
+    value = std::stoull(label.substr(start));
+    return true;
+  }
+
+  // Writes a C++ string_view literal of the label (octal escapes, so any byte is safe)
+  void static writeLiteral(const std::string &label, std::ostream &out)
+  {
+    out << "std::string_view(\"";
+    for (unsigned char c : label)
+    {
+      if (c == '"' || c == '\\')
+        out << '\\' << c;
+      else if (c < 32 || c >= 127 || c == '?')
+      {
+        char escaped[5];
+        std::snprintf(escaped, sizeof(escaped), "\\%03o", c);
+        out << escaped;
+      }
+      else
+        out << c;
+    }
+    out << "\", " << label.size() << ")";
+  }
+
+  // Writes the label inside a line comment, shortened, with anything that could end or extend the comment replaced
+  void static writeComment(const std::string &label, std::ostream &out)
+  {
+    size_t shown = label.size() > 60 ? 60 : label.size();
+    for (size_t i = 0; i < shown; i++)
+    {
+      unsigned char c = label[i];
+      out << ((c < 32 || c >= 127 || c == '\\') ? '?' : char(c));
+    }
+    if (shown < label.size())
+      out << "...";
+  }
+
+  // The hint macro for a test that succeeds for the given share of the searches reaching it.
+  // Tests come most likely first, so a test is never the unlikely side of a lopsided split.
+  const char static *hintOf(double share, bool weighted)
+  {
+    return (weighted && share >= LIKELY_SHARE) ? "OBST_LIKELY" : "";
+  }
+
+  void static writeCondition(const char *hint, const std::string &condition, std::ostream &out)
+  {
+    if (*hint)
+      out << "if (" << hint << "(" << condition << "))";
+    else
+      out << "if (" << condition << ")";
+  }
+
+  // Writes what happens when the search goes to `child` (a jump to its code, or a miss in `gap`)
+  void static writeTarget(const TreeNode *child, int gap, std::unordered_map<const TreeNode *, int> &rankOf, std::ostream &out)
+  {
+    if (child)
+      out << "goto node_" << rankOf[child] << ";";
+    else
+      out << "return miss(gap, " << gap << ");";
+  }
+
+  void static writePreamble(const std::string &functionName, bool anyInteger, bool anyLongNumber, std::ostream &out)
+  {
+    out << "// Generated by TreeCodeGen from an Optimal Binary Search Tree, do not edit.\n";
+    out << "#pragma once\n\n";
+    out << "#include <cstdint>\n";
+    out << "#include <string_view>\n\n";
+    out << "#ifndef OBST_LIKELY\n";
+    out << "#if defined(__GNUC__) || defined(__clang__)\n";
+    out << "#define OBST_LIKELY(x) __builtin_expect(!!(x), 1)\n";
+    out << "#else\n";
+    out << "#define OBST_LIKELY(x) (x)\n";
+    out << "#endif\n";
+    out << "#endif\n\n";
+
+    out << "namespace " << functionName << "_detail\n{\n";
+    out << "  inline int miss(int *gap, int k)\n  {\n";
+    out << "    if (gap)\n      *gap = k;\n";
+    out << "    return 0;\n  }\n";
+    if (anyLongNumber)
+    {
+      // Same ordering as Utils::compareStrings, for numeric labels too long for an integer
+      out << "\n  inline int compareLabel(std::string_view a, std::string_view b, bool aIsNum)\n  {\n";
+      out << "    if (aIsNum)\n    {\n";
+      out << "      while (a.size() > 1 && a[0] == '0')\n        a.remove_prefix(1);\n";
+      out << "      while (b.size() > 1 && b[0] == '0')\n        b.remove_prefix(1);\n";
+      out << "      if (a.size() != b.size())\n        return a.size() < b.size() ? -1 : 1;\n";
+      out << "    }\n";
+      out << "    return a.compare(b);\n  }\n";
+    }
+    out << "}\n\n";
+
+    out << "/**\n";
+    out << " * Searches for `key`, returns its 1-based rank among the labels or 0 if it is missing,\n";
+    out << " * in which case `*gap` (if given) is set to the index in q of the gap it falls in.\n";
+    out << " */\n";
+    out << "inline int " << functionName << "(std::string_view key, int *gap = nullptr)\n{\n";
+    out << "  using namespace " << functionName << "_detail;\n";
+    out << "  int c;\n";
+
+    if (anyInteger)
+    {
+      // Parse the key once, numeric keys are then compared to numeric labels by value
+      out << "  bool keyIsNum = !key.empty();\n";
+      out << "  std::uint64_t keyNum = 0;\n";
+      out << "  std::size_t digits = 0;\n";
+      out << "  for (char ch : key)\n  {\n";
+      out << "    if (ch < '0' || ch > '9')\n    {\n      keyIsNum = false;\n      break;\n    }\n";
+      out << "    if (digits > 0 || ch != '0')\n      digits++;\n";
+      out << "    keyNum = (digits > " << MAX_INT_DIGITS << ") ? UINT64_MAX : keyNum * 10 + std::uint64_t(ch - '0');\n";
+      out << "  }\n";
+    }
+    else if (anyLongNumber)
+    {
+      // Long numeric labels only need to know whether the key is numeric
+      out << "  bool keyIsNum = !key.empty();\n";
+      out << "  for (char ch : key)\n    if (ch < '0' || ch > '9')\n    {\n      keyIsNum = false;\n      break;\n    }\n";
+    }
+  }
+
+public:
+  /**
+   * @brief Writes the source of a search function for the tree to `out`.
+   *
+   * @param tree The tree to compile, its node probabilities and gap weights give the hints.
+   * @param functionName Name of the generated function (must be a valid C++ identifier).
+   * @param out The stream receiving the source.
+   */
+  void static generateSource(const Tree &tree, const std::string &functionName, std::ostream &out)
+  {
+    const TreeNode *root = tree.getRoot();
+    const Vector<float> &q = tree.getGapWeights();
+
+    // Rank every node in order, and sum p and q by rank to get the weight of any subtree
+    std::unordered_map<const TreeNode *, int> rankOf;
+    Vector<double> prefixP(1), prefixQ(1);
+    prefixP[0] = 0;
+    prefixQ[0] = (q.size() > 0) ? q[0] : 0;
+    bool anyInteger = false, anyLongNumber = false;
+    {
+      Tree::Iterator it = tree.begin(), end = tree.end();
+      int rank = 0;
+      for (; it != end; ++it)
+      {
+        rank++;
+        rankOf[&*it] = rank;
+        prefixP.push_back(prefixP[rank - 1] + it->p);
+        prefixQ.push_back(prefixQ[rank - 1] + ((size_t)rank < q.size() ? q[rank] : 0));
+
+        unsigned long long value;
+        if (integerLabel(it->key, value))
+          anyInteger = true;
+        else if (Utils::isNumeric(it->key))
+          anyLongNumber = true;
+      }
+    }
+    int n = (int)rankOf.size();
+    bool weighted = n > 0 && prefixP[n] + prefixQ[n] > 0;
+
+    // Weight of the searches reaching the subtree of ranks [lo, hi] (keys lo..hi, gaps lo-1..hi)
+    auto weightOf = [&prefixP, &prefixQ](int lo, int hi)
+    {
+      return prefixP[hi] - prefixP[lo - 1] + prefixQ[hi] - (lo >= 2 ? prefixQ[lo - 2] : 0.0);
+    };
+
+    writePreamble(functionName, anyInteger, anyLongNumber, out);
+
+    if (!root)
+    {
+      out << "  (void)key;\n";
+      out << "  (void)c;\n";
+      out << "  return miss(gap, 0);\n}\n";
+      return;
+    }
+
+    Vector<CodeFrame> stack;
+    stack.push_back({root, 1, n});
+
+    while (stack.size() > 0)
+    {
+      CodeFrame frame = stack.back();
+      stack.pop_back();
+      const TreeNode *node = frame.node;
+      int rank = rankOf[node];
+
+      double total = weightOf(frame.lo, frame.hi);
+      double shares[3] = {0, 0, 0}; // Found here, goes left, goes right
+      if (weighted && total > 0)
+      {
+        shares[0] = node->p / total;
+        shares[1] = (rank > frame.lo) ? weightOf(frame.lo, rank - 1) / total : ((size_t)rank - 1 < q.size() ? q[rank - 1] : 0) / total;
+        shares[2] = (rank < frame.hi) ? weightOf(rank + 1, frame.hi) / total : ((size_t)rank < q.size() ? q[rank] : 0) / total;
+      }
+
+      // The root is reached by falling through the preamble, every other node by a jump
+      if (node != root)
+        out << "node_" << rank << ":\n";
+      out << "  // ";
+      writeComment(node->key, out);
+      if (weighted)
+        out << " (found " << shares[0] << ", left " << shares[1] << ", right " << shares[2] << ")";
+      out << "\n";
+
+      unsigned long long value;
+      out << "  c = ";
+      if (integerLabel(node->key, value))
+      {
+        if (value == 0)
+          out << "keyIsNum ? (keyNum == 0 ? 0 : 1) : key.compare(";
+        else
+          out << "keyIsNum ? (keyNum < " << value << "ULL ? -1 : keyNum > " << value << "ULL ? 1 : 0) : key.compare(";
+        writeLiteral(node->key, out);
+        out << ");\n";
+      }
+      else if (Utils::isNumeric(node->key))
+      {
+        out << "compareLabel(key, ";
+        writeLiteral(node->key, out);
+        out << ", keyIsNum);\n";
+      }
+      else
+      {
+        out << "key.compare(";
+        writeLiteral(node->key, out);
+        out << ");\n";
+      }
+
+      // Test the outcomes from the most to the least likely, the last one needs no test
+      int order[3] = {0, 1, 2};
+      for (int a = 1; a < 3; a++)
+        for (int b = a; b > 0 && shares[order[b]] > shares[order[b - 1]]; b--)
+        {
+          int swapped = order[b];
+          order[b] = order[b - 1];
+          order[b - 1] = swapped;
+        }
+
+      // A test is hinted by its share of the searches that get past the tests above it
+      double remaining = shares[0] + shares[1] + shares[2];
+      for (int k = 0; k < 3; k++)
+      {
+        int outcome = order[k];
+        out << "  ";
+        if (k < 2)
+        {
+          double share = remaining > 0 ? shares[outcome] / remaining : 0;
+          writeCondition(hintOf(share, weighted), outcome == 0 ? "c == 0" : outcome == 1 ? "c < 0" : "c > 0", out);
+          out << "\n    ";
+          remaining -= shares[outcome];
+        }
+
+        if (outcome == 0)
+          out << "return " << rank << ";";
+        else if (outcome == 1)
+          writeTarget(node->left, rank - 1, rankOf, out);
+        else
+          writeTarget(node->right, rank, rankOf, out);
+        out << "\n";
+      }
+
+      if (node->right)
+        stack.push_back({node->right, rank + 1, frame.hi});
+      if (node->left)
+        stack.push_back({node->left, frame.lo, rank - 1});
+    }
+
+    out << "}\n";
+  }
+
+  /**
+   * @brief Writes the search function for the tree to a header file.
+   *
+   * @param tree The tree to compile.
+   * @param filename The header to write (e.g. "obst_search.h").
+   * @param functionName Name of the generated function (default: "obstSearch").
+   * @return true if the file was written.
+   */
+  bool static generateSourceFile(const Tree &tree, const std::string &filename, const std::string &functionName = "obstSearch")
+  {
+    std::ofstream file(filename);
+    if (!file.is_open())
+    {
+      std::cerr << "Failed to open file: " << filename << std::endl;
+      return false;
+    }
+
+    generateSource(tree, functionName, file);
+    file.close();
+
+    std::cout << "Search function generated successfully: " << filename << std::endl;
+    return true;
+  }
+};
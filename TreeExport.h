@@ -0,0 +1,307 @@
+/**
+ * @file TreeExport.h
+ * @brief Writes a built tree as JSON or as compact preorder text, for tools that cannot read DOT.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <string>
+#include "Vector.h"
+#include "BufferedWriter.h"
+#include "TreeNode.h"
+#include "Tree.h"
+
+/**
+ * @class TreeExport
+ * @brief Streams a `Tree` through a large buffer, without recursion, in one of three formats.
+ *
+ * Every node carries its key, its index, its depth (root is 0) and, when the tree has
+ * probabilities, its p and the weight of its subtree (p of its keys plus q of its gaps).
+ *
+ * - `NESTED_JSON`: `{"q":[...],"root":{"key":...,"left":{...}|null,"right":{...}|null}}`.
+ * - `FLAT_JSON`: `{"q":[...],"root":0,"nodes":[...]}`, nodes in preorder, children given by
+ *   their position in the list (-1 for none, root is -1 when the tree is empty).
+ * - `PREORDER_TEXT`: a `#obst-preorder 1 <nodes>` line, a `q` line, then one line per node in
+ *   preorder: `<children> <index> <depth> <p> <weight> <key>`, where children is `-`, `L`,
+ *   `R` or `LR` and rebuilds the shape. The key comes last, with `\`, tab and newline escaped.
+ *   p and weight are `-` when the tree has no probabilities.
+ */
+class TreeExport
+{
+public:
+  enum Format
+  {
+    NESTED_JSON,
+    FLAT_JSON,
+    PREORDER_TEXT
+  };
+
+private:
+  /**
+   * @brief A node in preorder, with its children's positions in the same order.
+   */
+  struct FlatNode
+  {
+    const TreeNode *node;
+    int left;
+    int right;
+    int depth;
+    double weight;
+  };
+
+  // Lists the nodes in preorder with their depths and subtree weights; true if the tree has probabilities
+  static bool flatten(const Tree &tree, Vector<FlatNode> &nodes)
+  {
+    const Vector<float> &q = tree.getGapWeights();
+    auto gapWeight = [&q](int gap)
+    { return (gap >= 0 && gap < (int)q.size()) ? double(q[gap]) : 0.0; };
+
+    // Preorder with an explicit stack; each entry remembers where to store its position
+    struct Pending
+    {
+      const TreeNode *node;
+      int parent;
+      bool isLeft;
+      int depth;
+    };
+    Vector<Pending> stack;
+    if (tree.getRoot())
+      stack.push_back({tree.getRoot(), -1, false, 0});
+
+    bool weighted = false;
+    while (stack.size() > 0)
+    {
+      Pending top = stack.back();
+      stack.pop_back();
+
+      int position = nodes.size();
+      nodes.push_back({top.node, -1, -1, top.depth, top.node->p});
+      if (top.parent >= 0)
+        (top.isLeft ? nodes[top.parent].left : nodes[top.parent].right) = position;
+      if (top.node->p > 0)
+        weighted = true;
+
+      // Gaps under missing children belong to this subtree
+      if (top.node->index > 0)
+      {
+        if (!top.node->left)
+          nodes[position].weight += gapWeight(top.node->index - 1);
+        if (!top.node->right)
+          nodes[position].weight += gapWeight(top.node->index);
+      }
+
+      if (top.node->right)
+        stack.push_back({top.node->right, position, false, top.depth + 1});
+      if (top.node->left)
+        stack.push_back({top.node->left, position, true, top.depth + 1});
+    }
+
+    // Children come after their parent in preorder, so one backward pass sums the subtrees
+    for (size_t k = nodes.size(); k-- > 0;)
+    {
+      if (nodes[k].left >= 0)
+        nodes[k].weight += nodes[nodes[k].left].weight;
+      if (nodes[k].right >= 0)
+        nodes[k].weight += nodes[nodes[k].right].weight;
+      if (nodes[k].weight > 0)
+        weighted = true;
+    }
+    return weighted;
+  }
+
+  static void writeGaps(const Tree &tree, BufferedWriter &writer, char separator)
+  {
+    const Vector<float> &q = tree.getGapWeights();
+    for (size_t k = 0; k < q.size(); k++)
+    {
+      if (k > 0)
+        writer.put(separator);
+      writer.putNumber(q[k]);
+    }
+  }
+
+  // The fields every JSON node starts with, up to the children
+  static void writeJsonFields(const FlatNode &flat, bool weighted, BufferedWriter &writer)
+  {
+    writer.put("{\"key\":");
+    writer.putJsonString(flat.node->key);
+    writer.put(",\"index\":");
+    writer.putNumber(flat.node->index);
+    writer.put(",\"depth\":");
+    writer.putNumber(flat.depth);
+    if (weighted)
+    {
+      writer.put(",\"p\":");
+      writer.putNumber(flat.node->p);
+      writer.put(",\"weight\":");
+      writer.putNumber(float(flat.weight));
+    }
+  }
+
+  static void writeNestedJson(const Tree &tree, const Vector<FlatNode> &nodes, bool weighted, BufferedWriter &writer)
+  {
+    writer.put("{\"q\":[");
+    writeGaps(tree, writer, ',');
+    writer.put("],\"root\":");
+
+    if (nodes.size() == 0)
+    {
+      writer.put("null}\n");
+      return;
+    }
+
+    // Each node is visited three times: to open it and write its left child, to write
+    // its right child, and to close it
+    struct Frame
+    {
+      int position;
+      int stage;
+    };
+    Vector<Frame> stack;
+    stack.push_back({0, 0});
+
+    while (stack.size() > 0)
+    {
+      Frame top = stack.back();
+      stack.pop_back();
+      const FlatNode &flat = nodes[top.position];
+
+      if (top.stage == 0)
+      {
+        writeJsonFields(flat, weighted, writer);
+        writer.put(",\"left\":");
+        stack.push_back({top.position, 1});
+        if (flat.left >= 0)
+          stack.push_back({flat.left, 0});
+        else
+          writer.put("null");
+      }
+      else if (top.stage == 1)
+      {
+        writer.put(",\"right\":");
+        stack.push_back({top.position, 2});
+        if (flat.right >= 0)
+          stack.push_back({flat.right, 0});
+        else
+          writer.put("null");
+      }
+      else
+        writer.put('}');
+    }
+    writer.put("}\n");
+  }
+
+  static void writeFlatJson(const Tree &tree, const Vector<FlatNode> &nodes, bool weighted, BufferedWriter &writer)
+  {
+    writer.put("{\"q\":[");
+    writeGaps(tree, writer, ',');
+    writer.put("],\"root\":");
+    writer.putNumber(nodes.size() > 0 ? 0 : -1);
+    writer.put(",\"nodes\":[");
+
+    for (size_t k = 0; k < nodes.size(); k++)
+    {
+      if (k > 0)
+        writer.put(",\n");
+      writeJsonFields(nodes[k], weighted, writer);
+      writer.put(",\"left\":");
+      writer.putNumber(nodes[k].left);
+      writer.put(",\"right\":");
+      writer.putNumber(nodes[k].right);
+      writer.put('}');
+    }
+    writer.put("]}\n");
+  }
+
+  static void writePreorderText(const Tree &tree, const Vector<FlatNode> &nodes, bool weighted, BufferedWriter &writer)
+  {
+    writer.put("#obst-preorder 1 ");
+    writer.putNumber(nodes.size());
+    writer.put("\nq");
+    if (tree.getGapWeights().size() > 0)
+      writer.put(' ');
+    writeGaps(tree, writer, ' ');
+    writer.put('\n');
+
+    for (size_t k = 0; k < nodes.size(); k++)
+    {
+      const FlatNode &flat = nodes[k];
+      if (flat.left >= 0 && flat.right >= 0)
+        writer.put("LR");
+      else if (flat.left >= 0)
+        writer.put('L');
+      else if (flat.right >= 0)
+        writer.put('R');
+      else
+        writer.put('-');
+
+      writer.put(' ');
+      writer.putNumber(flat.node->index);
+      writer.put(' ');
+      writer.putNumber(flat.depth);
+      writer.put(' ');
+      if (weighted)
+      {
+        writer.putNumber(flat.node->p);
+        writer.put(' ');
+        writer.putNumber(float(flat.weight));
+      }
+      else
+        writer.put("- -");
+      writer.put(' ');
+      writer.putTextKey(flat.node->key);
+      writer.put('\n');
+    }
+  }
+
+public:
+  /**
+   * @brief Writes `tree` to `out` in the given format.
+   */
+  static void write(const Tree &tree, std::ostream &out, Format format)
+  {
+    Vector<FlatNode> nodes;
+    bool weighted = flatten(tree, nodes);
+
+    BufferedWriter writer(out);
+    switch (format)
+    {
+    case NESTED_JSON:
+      writeNestedJson(tree, nodes, weighted, writer);
+      break;
+    case FLAT_JSON:
+      writeFlatJson(tree, nodes, weighted, writer);
+      break;
+    case PREORDER_TEXT:
+      writePreorderText(tree, nodes, weighted, writer);
+      break;
+    }
+  }
+
+  /**
+   * @brief Writes `tree` to a file in the given format.
+   *
+   * @return true on success; on failure the error is printed.
+   */
+  static bool writeFile(const Tree &tree, const std::string &filename, Format format)
+  {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+      std::cerr << "Failed to open file: " << filename << std::endl;
+      return false;
+    }
+
+    write(tree, out, format);
+    out.flush();
+    if (!out.good())
+    {
+      std::cerr << "Failed to write file: " << filename << std::endl;
+      return false;
+    }
+    return true;
+  }
+};
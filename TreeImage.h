@@ -0,0 +1,353 @@
+/**
+ * @file TreeImage.h
+ * @brief A pointer-free, memory-mappable image of a built tree, shared by many reader processes.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <memory>
+#include "Vector.h"
+#include "TreeNode.h"
+#include "Tree.h"
+#include "Utils.h"
+#include "MappedFile.h"
+#include "FileReplace.h"
+
+/**
+ * @class TreeImage
+ * @brief Writes a tree as a flat image and searches an image in place.
+ *
+ * Image layout (native byte order, every section 8-byte aligned):
+ * - Header (64 bytes): "OBSTIMG1", version, node count, gap count, and the offsets of the sections.
+ * - Nodes in breadth-first order, root first: key offset and length in the label blob,
+ *   child positions (-1 for none, always after the parent), key index and p.
+ * - Gap weights q (floats).
+ * - Label blob, the keys back to back.
+ *
+ * Since the image holds no pointers, every process can map the same file read-only and
+ * search it directly: opening an image only checks its header. A new image is written
+ * next to the old one and renamed over it, so a reader sees either the old or the new
+ * file, and can switch to the new one with `refresh`.
+ *
+ * Copies of an image share its mapping, which is unmapped only when the last image using it
+ * is gone. Keys, nodes and gap weights read from an image stay valid while it keeps its
+ * mapping: `open` and a successful `refresh` move the image to a new one, so take a copy
+ * first to keep serving the old image (and its views) while switching. A single image is
+ * not synchronized: copy it per thread rather than refreshing it under readers.
+ */
+class TreeImage
+{
+public:
+  static constexpr uint32_t VERSION = 1;
+
+  /**
+   * @struct Node
+   * One node of the image.
+   */
+  struct Node
+  {
+    uint64_t keyOffset; // Offset of the key in the label blob
+    uint32_t keyLength;
+    int32_t left;  // Position of the left child, -1 for none
+    int32_t right; // Position of the right child, -1 for none
+    int32_t index; // 1-based position of the key among the labels (0 if unknown)
+    float p;
+    uint32_t reserved;
+  };
+
+  /**
+   * @struct Result
+   * The answer to a search in an image.
+   */
+  struct Result
+  {
+    int node = -1;  // Position of the node holding the key, -1 if missing
+    int index = 0;  // Key index of that node (0 if missing)
+    int gap = -1;   // On a miss, the index in q of the gap the key falls in
+  };
+
+private:
+  struct Header
+  {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t nodeCount;
+    uint64_t gapCount;
+    uint64_t nodesOffset;
+    uint64_t gapsOffset;
+    uint64_t blobOffset;
+    uint64_t blobBytes;
+  };
+
+  static_assert(sizeof(Header) == 64, "The image header must be 64 bytes");
+  static_assert(sizeof(Node) == 32, "Image nodes must be 32 bytes");
+
+  std::shared_ptr<const MappedFile> file; // Shared with the copies of this image
+  std::string path;
+  const Header *header;
+  const Node *nodes;
+  const float *gaps;
+  const char *blob;
+
+  static uint64_t alignUp(uint64_t offset)
+  {
+    return (offset + 7) & ~uint64_t(7);
+  }
+
+  static void writePadding(std::ofstream &out, uint64_t &offset)
+  {
+    static const char zeros[8] = {};
+    uint64_t aligned = alignUp(offset);
+    out.write(zeros, aligned - offset);
+    offset = aligned;
+  }
+
+  bool checkHeader()
+  {
+    if (file->size() < sizeof(Header))
+      return false;
+
+    header = reinterpret_cast<const Header *>(file->data());
+    if (std::memcmp(header->magic, "OBSTIMG1", 8) != 0 || header->version != VERSION)
+      return false;
+
+    uint64_t size = file->size();
+    if (header->nodeCount > uint64_t(INT32_MAX) ||
+        header->nodesOffset % 8 || header->gapsOffset % 4 ||
+        header->nodesOffset > size || header->nodeCount > (size - header->nodesOffset) / sizeof(Node) ||
+        header->gapsOffset > size || header->gapCount > (size - header->gapsOffset) / sizeof(float) ||
+        header->blobOffset > size || header->blobBytes > size - header->blobOffset)
+      return false;
+
+    nodes = reinterpret_cast<const Node *>(file->data() + header->nodesOffset);
+    gaps = reinterpret_cast<const float *>(file->data() + header->gapsOffset);
+    blob = file->data() + header->blobOffset;
+    return true;
+  }
+
+  // Drops this image's hold on its mapping, copies keep theirs
+  void clear()
+  {
+    file.reset();
+    header = nullptr;
+    nodes = nullptr;
+    gaps = nullptr;
+    blob = nullptr;
+  }
+
+public:
+  TreeImage() : header(nullptr), nodes(nullptr), gaps(nullptr), blob(nullptr) {}
+
+  TreeImage(const TreeImage &) = default;
+  TreeImage &operator=(const TreeImage &) = default;
+
+  /**
+   * @brief Writes the image of `tree` and publishes it at `filename` with an atomic rename.
+   *
+   * The image is written to a temporary file next to `filename` first, so readers never
+   * see a partial image. Readers that mapped the previous image keep using it until they
+   * call `refresh`.
+   *
+   * @return true on success; on failure the error is printed and `filename` is unchanged.
+   */
+  static bool publish(const Tree &tree, const std::string &filename)
+  {
+    // Breadth-first order, so the top levels searched by every lookup share a few pages
+    Vector<const TreeNode *> order;
+    if (tree.getRoot())
+      order.push_back(tree.getRoot());
+    for (size_t head = 0; head < order.size(); head++)
+    {
+      if (order[head]->left)
+        order.push_back(order[head]->left);
+      if (order[head]->right)
+        order.push_back(order[head]->right);
+    }
+
+    Vector<Node> flat(order.size());
+    uint64_t blobBytes = 0;
+    for (size_t k = 0, next = 1; k < order.size(); k++)
+    {
+      const TreeNode *node = order[k];
+      Node &out = flat[k];
+      out.keyOffset = blobBytes;
+      out.keyLength = uint32_t(node->key.size());
+      out.index = node->index;
+      out.p = node->p;
+      out.reserved = 0;
+      out.left = node->left ? int32_t(next++) : -1; // Children were queued in this order
+      out.right = node->right ? int32_t(next++) : -1;
+      blobBytes += node->key.size();
+    }
+
+    const Vector<float> &q = tree.getGapWeights();
+
+    Header head = {};
+    std::memcpy(head.magic, "OBSTIMG1", 8);
+    head.version = VERSION;
+    head.nodeCount = flat.size();
+    head.gapCount = q.size();
+    head.nodesOffset = sizeof(Header);
+    head.gapsOffset = head.nodesOffset + flat.size() * sizeof(Node);
+    head.blobOffset = alignUp(head.gapsOffset + q.size() * sizeof(float));
+    head.blobBytes = blobBytes;
+
+    std::string temporary = FileReplace::temporaryFor(filename);
+
+    {
+      std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+      if (!out.is_open())
+      {
+        std::cerr << "Failed to open file: " << temporary << std::endl;
+        return false;
+      }
+
+      out.write(reinterpret_cast<const char *>(&head), sizeof(Header));
+      for (size_t k = 0; k < flat.size(); k++)
+        out.write(reinterpret_cast<const char *>(&flat[k]), sizeof(Node));
+      for (size_t k = 0; k < q.size(); k++)
+        out.write(reinterpret_cast<const char *>(&q[k]), sizeof(float));
+      uint64_t offset = head.gapsOffset + q.size() * sizeof(float);
+      writePadding(out, offset);
+      for (size_t k = 0; k < order.size(); k++)
+        out.write(order[k]->key.data(), order[k]->key.size());
+
+      out.flush();
+      if (!out.good())
+      {
+        std::cerr << "Failed to write file: " << temporary << std::endl;
+        out.close();
+        std::remove(temporary.c_str());
+        return false;
+      }
+    }
+
+    if (!FileReplace::commit(temporary, filename))
+    {
+      std::cerr << "Failed to publish image: " << filename << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Maps an image for searching, only its header is read.
+   *
+   * The previous mapping is released by this image, but stays mapped for its copies.
+   *
+   * @return true on success; on failure the error is printed and nothing is open.
+   */
+  bool open(const std::string &filename)
+  {
+    clear();
+    path = filename;
+
+    std::shared_ptr<MappedFile> mapping = std::make_shared<MappedFile>();
+    if (!mapping->open(filename))
+    {
+      std::cerr << "Failed to open file: " << filename << std::endl;
+      return false;
+    }
+    file = mapping;
+    if (!checkHeader())
+    {
+      std::cerr << "Not a valid tree image: " << filename << std::endl;
+      clear();
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Switches to the latest image if the file was replaced since it was opened.
+   *
+   * Like `open`, this invalidates what was read from this image unless a copy still holds
+   * the old mapping.
+   *
+   * @return true if a new image was mapped.
+   */
+  bool refresh()
+  {
+#ifdef OBST_HAVE_MMAP
+    struct stat info;
+    if (path.empty() || stat(path.c_str(), &info) != 0 || (file && info.st_dev == file->device() && info.st_ino == file->inode()))
+      return false;
+    return open(path);
+#else
+    return !path.empty() && open(path);
+#endif
+  }
+
+  bool isOpen() const
+  {
+    return header != nullptr;
+  }
+
+  size_t size() const
+  {
+    return header ? size_t(header->nodeCount) : 0;
+  }
+
+  const Node &nodeAt(int position) const
+  {
+    return nodes[position];
+  }
+
+  // The key of the node at `position` (empty if the image is damaged)
+  std::string_view keyAt(int position) const
+  {
+    const Node &node = nodes[position];
+    if (node.keyOffset > header->blobBytes || node.keyLength > header->blobBytes - node.keyOffset)
+      return std::string_view();
+    return std::string_view(blob + node.keyOffset, node.keyLength);
+  }
+
+  // Gap weights q stored with the image
+  float gapWeight(int gap) const
+  {
+    return (header && gap >= 0 && uint64_t(gap) < header->gapCount) ? gaps[gap] : 0;
+  }
+
+  /**
+   * @brief Searches the image in place, with the same ordering as `Utils::compareStrings`.
+   *
+   * Child positions are checked on the way (they must point forward and stay in the image),
+   * so a damaged image gives a wrong answer at worst, never a crash or an endless loop.
+   */
+  Result find(std::string_view key) const
+  {
+    Result result;
+    int64_t count = header ? int64_t(header->nodeCount) : 0;
+    int position = 0;
+    if (count == 0)
+      return result;
+
+    while (true)
+    {
+      const Node &node = nodes[position];
+      int cmp = Utils::compareStrings(key, keyAt(position));
+      if (cmp == 0)
+      {
+        result.node = position;
+        result.index = node.index;
+        return result;
+      }
+
+      int next = (cmp < 0) ? node.left : node.right;
+      if (next <= position || next >= count)
+      {
+        result.gap = (node.index <= 0) ? -1 : (cmp < 0) ? node.index - 1 : node.index;
+        return result;
+      }
+      position = next;
+    }
+  }
+};
@@ -13,6 +13,8 @@ public:
   std::string key; // The value or label of the node.
   TreeNode *left;  // Pointer to the left child node.
   TreeNode *right; // Pointer to the right child node.
+  int index;       // 1-based position of the key in the sorted labels (0 if unknown).
+  float p;         // Probability of successfully searching for this key (0 if unknown).
 
   /**
    * @brief Constructor for the TreeNode class.
@@ -20,6 +22,9 @@ public:
    * Initializes the node with a given key and sets its child pointers to null.
    *
    * @param key The value or label to be assigned to the node.
+   * @param index The 1-based position of the key in the sorted labels (default: 0, unknown).
+   * @param p The probability of successfully searching for the key (default: 0, unknown).
    */
-  TreeNode(const std::string &key) : key(key), left(nullptr), right(nullptr) {}
+  TreeNode(const std::string &key, int index = 0, float p = 0)
+      : key(key), left(nullptr), right(nullptr), index(index), p(p) {}
 };
@@ -0,0 +1,238 @@
+/**
+ * @file TreePublisher.h
+ * @brief Publishes rebuilt trees to concurrent readers without ever blocking them (RCU style).
+ *
+ * The current tree is behind a single atomic pointer. A new tree is published with one
+ * atomic swap, readers that are still using the old tree finish on it, and the old tree
+ * is freed once every reader that could have seen it has left its read section.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include "Vector.h"
+#include "Tree.h"
+
+/**
+ * @class TreePublisher
+ * @brief Holds the tree served to readers and swaps in new ones atomically.
+ *
+ * Each reader thread registers a `Reader`, and wraps its lookups in `lock()` / `unlock()`
+ * (or a `ReadGuard`). While locked, every access to the tree costs one atomic load.
+ * Entering a read section records the current epoch; a replaced tree is tagged with
+ * the epoch of its replacement and freed once no reader is in an older section.
+ */
+class TreePublisher
+{
+public:
+  static constexpr int MAX_READERS = 128;
+
+private:
+  struct alignas(64) ReaderSlot // One cache line per reader, so readers do not slow each other down
+  {
+    std::atomic<bool> used{false};
+    std::atomic<uint64_t> epoch{0}; // Epoch seen when the read section started, 0 when not reading
+  };
+
+  struct Retired
+  {
+    const Tree *tree;
+    uint64_t epoch; // Readers that started at or before this epoch may still use the tree
+  };
+
+  std::atomic<const Tree *> current;
+  std::atomic<uint64_t> epoch;
+  ReaderSlot slots[MAX_READERS];
+
+  std::mutex writerLock; // Serializes publishers, readers never take it
+  Vector<Retired> retired;
+
+  // Oldest epoch a reader is currently in, or UINT64_MAX if nobody is reading
+  uint64_t oldestReader() const
+  {
+    uint64_t oldest = UINT64_MAX;
+    for (const ReaderSlot &slot : slots)
+    {
+      uint64_t seen = slot.epoch.load(std::memory_order_seq_cst);
+      if (seen != 0 && seen < oldest)
+        oldest = seen;
+    }
+    return oldest;
+  }
+
+  // Frees the retired trees nobody can be using anymore (writerLock must be held)
+  size_t reclaimLocked()
+  {
+    uint64_t oldest = oldestReader();
+    Vector<Retired> kept;
+    size_t freed = 0;
+    for (size_t i = 0; i < retired.size(); i++)
+    {
+      if (retired[i].epoch < oldest)
+      {
+        delete retired[i].tree;
+        freed++;
+      }
+      else
+      {
+        kept.push_back(retired[i]);
+      }
+    }
+    retired = kept;
+    return freed;
+  }
+
+public:
+  /**
+   * @class Reader
+   * @brief A registered reader, meant to be owned by a single thread.
+   */
+  class Reader
+  {
+  private:
+    TreePublisher &publisher;
+    int slot;
+
+  public:
+    /**
+     * @throws std::runtime_error If MAX_READERS readers are already registered.
+     */
+    explicit Reader(TreePublisher &publisher) : publisher(publisher), slot(-1)
+    {
+      for (int i = 0; i < MAX_READERS; i++)
+      {
+        bool expected = false;
+        if (publisher.slots[i].used.compare_exchange_strong(expected, true))
+        {
+          slot = i;
+          return;
+        }
+      }
+      throw std::runtime_error("Too many readers in TreePublisher::Reader");
+    }
+
+    ~Reader()
+    {
+      unlock();
+      publisher.slots[slot].used.store(false, std::memory_order_release);
+    }
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    // Starts a read section (sections do not nest), trees seen from now on stay alive until `unlock`
+    void lock()
+    {
+      publisher.slots[slot].epoch.store(publisher.epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+
+    // Ends the read section, references to the tree must not be used after this
+    void unlock()
+    {
+      publisher.slots[slot].epoch.store(0, std::memory_order_release);
+    }
+
+    // The current tree (one atomic load), only valid inside a read section
+    const Tree &tree() const
+    {
+      return *publisher.current.load(std::memory_order_seq_cst);
+    }
+
+    LookupResult find(const std::string &key) const
+    {
+      return tree().find(key);
+    }
+
+    // A copy of the current tree that stays valid after the read section (shares the nodes)
+    Tree snapshot() const
+    {
+      return tree();
+    }
+  };
+
+  /**
+   * @class ReadGuard
+   * @brief Keeps a reader inside a read section for the lifetime of the guard.
+   */
+  class ReadGuard
+  {
+  private:
+    Reader &reader;
+
+  public:
+    explicit ReadGuard(Reader &reader) : reader(reader)
+    {
+      reader.lock();
+    }
+
+    ~ReadGuard()
+    {
+      reader.unlock();
+    }
+
+    ReadGuard(const ReadGuard &) = delete;
+    ReadGuard &operator=(const ReadGuard &) = delete;
+  };
+
+  explicit TreePublisher(Tree initial = Tree()) : current(new Tree(std::move(initial))), epoch(1) {}
+
+  /**
+   * @brief Frees every tree. No reader may still be registered.
+   */
+  ~TreePublisher()
+  {
+    for (size_t i = 0; i < retired.size(); i++)
+      delete retired[i].tree;
+    delete current.load();
+  }
+
+  TreePublisher(const TreePublisher &) = delete;
+  TreePublisher &operator=(const TreePublisher &) = delete;
+
+  /**
+   * @brief Makes `tree` the one served to readers with a single atomic swap.
+   *
+   * Readers already looking at the previous tree keep using it. The previous tree
+   * is freed here or by a later call once all of them are done.
+   */
+  void publish(Tree tree)
+  {
+    const Tree *fresh = new Tree(std::move(tree));
+
+    std::lock_guard<std::mutex> guard(writerLock);
+    const Tree *old = current.exchange(fresh, std::memory_order_seq_cst);
+    uint64_t tag = epoch.fetch_add(1, std::memory_order_seq_cst);
+    retired.push_back({old, tag});
+    reclaimLocked();
+  }
+
+  /**
+   * @brief Frees the replaced trees that no reader can still be using.
+   *
+   * @return The number of trees freed.
+   */
+  size_t reclaim()
+  {
+    std::lock_guard<std::mutex> guard(writerLock);
+    return reclaimLocked();
+  }
+
+  // Number of replaced trees waiting for readers to finish
+  size_t pendingReclaim()
+  {
+    std::lock_guard<std::mutex> guard(writerLock);
+    return retired.size();
+  }
+
+  // A copy of the current tree for a writer or a one-off reader (shares the nodes)
+  Tree snapshot()
+  {
+    Reader reader(*this);
+    ReadGuard guard(reader);
+    return reader.snapshot();
+  }
+};
@@ -6,47 +6,71 @@
 #include <cstdlib> // For system()
 #include <string>
 #include "TreeNode.h"
+#include "Vector.h"
 #include "Tree.h"
 #include "Settings.h"
 
 class TreeVisualization
 {
 private:
-  void static generateDotHelper(TreeNode *node, std::ofstream &dotFile, int &nullCount)
+  /**
+   * @brief A node waiting on the stack, and whether its left edge has already been written.
+   */
+  struct DotFrame
   {
-    if (!node)
-      return;
+    const TreeNode *node;
+    bool leftDone;
+  };
 
-    // If the node has a left child, create an edge
-    if (node->left)
+  void static writeEdge(const TreeNode *node, const TreeNode *child, std::ofstream &dotFile, int &nullCount)
+  {
+    // If the node has a child, create an edge
+    if (child)
     {
-      dotFile << "  \"" << node->key << "\" -> \"" << node->left->key << "\";\n";
-      generateDotHelper(node->left, dotFile, nullCount);
+      dotFile << "  \"" << node->key << "\" -> \"" << child->key << "\";\n";
     }
     else
     {
-      // Represent null node for left child
+      // Represent null node for the missing child
       dotFile << "  null" << nullCount << " [shape=point];\n";
       dotFile << "  \"" << node->key << "\" -> null" << nullCount << ";\n";
       nullCount++;
     }
+  }
 
-    // If the node has a right child, create an edge
-    if (node->right)
-    {
-      dotFile << "  \"" << node->key << "\" -> \"" << node->right->key << "\";\n";
-      generateDotHelper(node->right, dotFile, nullCount);
-    }
-    else
+  // Writes the edges in preorder (left subtree before right) with an explicit stack instead of recursion
+  void static generateDotHelper(const TreeNode *node, std::ofstream &dotFile, int &nullCount)
+  {
+    if (!node)
+      return;
+
+    Vector<DotFrame> stack;
+    stack.push_back({node, false});
+
+    while (stack.size() > 0)
     {
-      // Represent null node for right child
-      dotFile << "  null" << nullCount << " [shape=point];\n";
-      dotFile << "  \"" << node->key << "\" -> null" << nullCount << ";\n";
-      nullCount++;
+      DotFrame top = stack.back();
+      stack.pop_back();
+
+      if (!top.leftDone)
+      {
+        writeEdge(top.node, top.node->left, dotFile, nullCount);
+
+        // Come back for the right edge once the whole left subtree is written
+        stack.push_back({top.node, true});
+        if (top.node->left)
+          stack.push_back({top.node->left, false});
+      }
+      else
+      {
+        writeEdge(top.node, top.node->right, dotFile, nullCount);
+        if (top.node->right)
+          stack.push_back({top.node->right, false});
+      }
     }
   }
 
-  void static generateDotFile(const std::string &filename, TreeNode *root)
+  void static generateDotFile(const std::string &filename, const TreeNode *root)
   {
     std::ofstream dotFile(filename); // Open file for writing
     if (!dotFile.is_open())
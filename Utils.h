@@ -8,8 +8,11 @@
 #include <iostream>
 #include <cstdio>
 #include <string>
+#include <string_view>
 #include <limits>
 #include "Vector.h"
+#include "TaskPool.h"
+#include "LabelIndex.h"
 
 namespace Utils
 {
@@ -78,7 +81,10 @@ namespace Utils
 #endif
   }
 
-  std::string readLabel(const Vector<std::string> &vec, std::string msg = "Enter a string: ", bool isDeleted = false)
+  /**
+   * @brief Reads a label, asking again while it is already in `index` (unless `isDeleted`).
+   */
+  std::string readLabel(const LabelIndex &index, std::string msg = "Enter a string: ", bool isDeleted = false)
   {
     std::string input;
     bool valid = false; // Valid if not found (if return -1)
@@ -88,7 +94,7 @@ namespace Utils
       std::cin >> input;
       if (std::cin.good())
       {
-        if (vec.findOne(input) == -1 || isDeleted)
+        if (isDeleted || !index.contains(input))
         {
           valid = true; // everything went well, we'll get out of the loop and return the value
         }
@@ -162,50 +168,255 @@ namespace Utils
     return !str.empty();
   }
 
-  // Function to compare two strings
-  int compareStrings(const std::string &a, const std::string &b)
+  /**
+   * @brief Compares two labels: numeric labels by value, anything else lexicographically.
+   *
+   * Numeric labels are compared digit by digit (ignoring leading zeros), which gives
+   * the same result as comparing their values, without converting them and at any length.
+   */
+  int compareStrings(std::string_view a, std::string_view b)
   {
-    bool aIsNumeric = isNumeric(a);
-    bool bIsNumeric = isNumeric(b);
+    auto numeric = [](std::string_view s)
+    {
+      for (char c : s)
+        if (!std::isdigit((unsigned char)c))
+          return false;
+      return !s.empty();
+    };
 
-    if (aIsNumeric && bIsNumeric)
+    if (numeric(a) && numeric(b))
     {
-      // Compare as integers if both are numeric
-      long long numA = std::stoll(a);
-      long long numB = std::stoll(b);
-      if (numA < numB)
-        return -1;
-      if (numA > numB)
-        return 1;
-      return 0; // Equal
+      // Drop leading zeros (keeping one digit), then the longer number is the bigger one
+      while (a.size() > 1 && a[0] == '0')
+        a.remove_prefix(1);
+      while (b.size() > 1 && b[0] == '0')
+        b.remove_prefix(1);
+      if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
     }
 
     // Compare lexicographically
-    if (a < b)
-      return -1;
-    if (a > b)
-      return 1;
-    return 0;
+    int result = a.compare(b);
+    return (result < 0) ? -1 : (result > 0) ? 1 : 0;
   }
 
-  void sortInputs(Vector<std::string> &_dataLabels, Vector<float> &_P)
+  // Labels at least this many are sorted in parallel chunks by `sortInputs`
+  constexpr size_t PARALLEL_SORT_CUTOFF = 1 << 16;
+
+  /**
+   * @brief A label prepared once for sorting, so comparing two of them needs no parsing.
+   */
+  struct SortKey
+  {
+    bool numeric;            // All digits, with a value that fits in a long long
+    long long value;         // The value, if numeric
+    const std::string *text; // The label itself
+  };
+
+  SortKey makeSortKey(const std::string &label)
+  {
+    SortKey key = {false, 0, &label};
+
+    // Up to 18 significant digits always fit, longer numbers are compared digit by digit
+    size_t first = 0;
+    while (first + 1 < label.size() && label[first] == '0')
+      first++;
+    if (isNumeric(label) && label.size() - first <= 18)
+    {
+      key.numeric = true;
+      for (size_t i = first; i < label.size(); i++)
+        key.value = key.value * 10 + (label[i] - '0');
+    }
+    return key;
+  }
+
+  // Same result as `compareStrings` on the two labels
+  int compareSortKeys(const SortKey &a, const SortKey &b)
+  {
+    if (a.numeric && b.numeric)
+      return (a.value < b.value) ? -1 : (a.value > b.value) ? 1 : 0;
+    return compareStrings(*a.text, *b.text);
+  }
+
+  // Merges the sorted runs [begin, mid) and [mid, end) of `from` into `to`, keeping equal keys in order
+  void mergeRuns(const SortKey *keys, const size_t *from, size_t *to, size_t begin, size_t mid, size_t end)
   {
-    int n = _dataLabels.size(); // Number of nodes
+    size_t left = begin, right = mid, out = begin;
+    while (left < mid && right < end)
+      to[out++] = (compareSortKeys(keys[from[right]], keys[from[left]]) < 0) ? from[right++] : from[left++];
+    while (left < mid)
+      to[out++] = from[left++];
+    while (right < end)
+      to[out++] = from[right++];
+  }
 
-    for (int i = 0; i < n - 1; i++)
+  /**
+   * @brief Sorts the positions [begin, end) of `order` by their keys, with a bottom-up merge sort.
+   *
+   * `buffer` has the same size as `order`; only its [begin, end) part is used.
+   */
+  void sortRange(const SortKey *keys, size_t *order, size_t *buffer, size_t begin, size_t end)
+  {
+    // Short runs by insertion, then runs of doubling width are merged back and forth
+    const size_t RUN = 16;
+    for (size_t runBegin = begin; runBegin < end; runBegin += RUN)
     {
-      for (int j = 0; j < n - i - 1; j++)
+      size_t runEnd = (end - runBegin < RUN) ? end : runBegin + RUN;
+      for (size_t i = runBegin + 1; i < runEnd; i++)
       {
-        // if (_dataLabels[j] > _dataLabels[j + 1])
-        if (compareStrings(_dataLabels[j], _dataLabels[j + 1]) == 1)
-        {
-          // 0 1 2 3 4 5   => P
-          // _ 0 1 2 3 4   => label
-          _swap(_dataLabels[j], _dataLabels[j + 1]);
-          _swap(_P[j + 1], _P[j + 2]);
-        }
+        size_t moving = order[i], j = i;
+        for (; j > runBegin && compareSortKeys(keys[moving], keys[order[j - 1]]) < 0; j--)
+          order[j] = order[j - 1];
+        order[j] = moving;
+      }
+    }
+
+    size_t *from = order, *to = buffer;
+    for (size_t width = RUN; width < end - begin; width *= 2)
+    {
+      for (size_t left = begin; left < end; left += 2 * width)
+      {
+        size_t mid = (end - left < width) ? end : left + width;
+        size_t right = (end - mid < width) ? end : mid + width;
+        mergeRuns(keys, from, to, left, mid, right);
+      }
+      size_t *swapped = from;
+      from = to;
+      to = swapped;
+    }
+
+    if (from != order)
+      for (size_t i = begin; i < end; i++)
+        order[i] = from[i];
+  }
+
+  /**
+   * @brief Returns the positions of the labels in sorted order (as `compareStrings` orders them).
+   *
+   * Each label is parsed once into a `SortKey`, then the positions are merge sorted, so the
+   * sort takes O(n log n) cheap comparisons. Large inputs are sorted in chunks on the shared
+   * pool, and the chunks merged pairwise, each round of merges in parallel. Equal labels
+   * keep their order.
+   */
+  Vector<size_t> sortedOrder(const Vector<std::string> &labels)
+  {
+    size_t n = labels.size();
+    Vector<size_t> order(n);
+    if (n == 0)
+      return order;
+
+    Vector<SortKey> keys(n);
+    Vector<size_t> buffer(n);
+    for (size_t i = 0; i < n; i++)
+    {
+      keys[i] = makeSortKey(labels[i]);
+      order[i] = i;
+    }
+
+    const SortKey *keyData = &keys[0];
+    size_t *orderData = &order[0];
+    size_t *bufferData = &buffer[0];
+
+    TaskPool &pool = TaskPool::shared();
+    size_t chunks = (n >= PARALLEL_SORT_CUTOFF) ? size_t(pool.size()) + 1 : 1;
+    if (chunks == 1)
+    {
+      sortRange(keyData, orderData, bufferData, 0, n);
+      return order;
+    }
+
+    Vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c <= chunks; c++)
+      bounds[c] = n / chunks * c + ((c == chunks) ? n % chunks : 0);
+
+    {
+      TaskGroup group(pool);
+      for (size_t c = 0; c < chunks; c++)
+      {
+        size_t begin = bounds[c], end = bounds[c + 1];
+        group.run([=]
+                  { sortRange(keyData, orderData, bufferData, begin, end); });
+      }
+      group.wait();
+    }
+
+    // Merge neighbouring chunks until one is left, copying unpaired chunks across
+    size_t *from = orderData, *to = bufferData;
+    for (size_t step = 1; step < chunks; step *= 2)
+    {
+      TaskGroup group(pool);
+      for (size_t c = 0; c < chunks; c += 2 * step)
+      {
+        size_t begin = bounds[c];
+        size_t mid = bounds[(c + step < chunks) ? c + step : chunks];
+        size_t end = bounds[(c + 2 * step < chunks) ? c + 2 * step : chunks];
+        group.run([=]
+                  { mergeRuns(keyData, from, to, begin, mid, end); });
       }
+      group.wait();
+
+      size_t *swapped = from;
+      from = to;
+      to = swapped;
+    }
+
+    if (from != orderData)
+      for (size_t i = 0; i < n; i++)
+        orderData[i] = from[i];
+    return order;
+  }
+
+  /**
+   * @brief Sorts the labels, moving P[i + 1] along with labels[i] (P[0] is unused).
+   */
+  void sortInputs(Vector<std::string> &_dataLabels, Vector<float> &_P)
+  {
+    size_t n = _dataLabels.size(); // Number of nodes
+    Vector<size_t> order = sortedOrder(_dataLabels);
+
+    // Apply the permutation in one pass
+    Vector<std::string> labels(n);
+    Vector<float> P(_P.size());
+    if (_P.size() > 0)
+      P[0] = _P[0];
+    for (size_t k = 0; k < n; k++)
+    {
+      // 0 1 2 3 4 5   => P
+      // _ 0 1 2 3 4   => label
+      labels[k] = std::move(_dataLabels[order[k]]);
+      P[k + 1] = _P[order[k] + 1];
+    }
+
+    _dataLabels = std::move(labels);
+    _P = std::move(P);
+  }
+
+  /**
+   * @brief Sorts the labels, moving P[i + 1] and Q[i + 1] along with labels[i].
+   *
+   * For inputs where Q[i + 1] was given together with the key (Q[0] stays first).
+   */
+  void sortInputs(Vector<std::string> &_dataLabels, Vector<float> &_P, Vector<float> &_Q)
+  {
+    size_t n = _dataLabels.size();
+    Vector<size_t> order = sortedOrder(_dataLabels);
+
+    Vector<std::string> labels(n);
+    Vector<float> P(_P.size()), Q(_Q.size());
+    if (_P.size() > 0)
+      P[0] = _P[0];
+    if (_Q.size() > 0)
+      Q[0] = _Q[0];
+    for (size_t k = 0; k < n; k++)
+    {
+      labels[k] = std::move(_dataLabels[order[k]]);
+      P[k + 1] = _P[order[k] + 1];
+      Q[k + 1] = _Q[order[k] + 1];
     }
+
+    _dataLabels = std::move(labels);
+    _P = std::move(P);
+    _Q = std::move(Q);
   }
 
   bool getDataFromUser(Vector<std::string> &DataLables, int &N, Vector<float> &P, Vector<float> &Q)
@@ -223,6 +434,8 @@ namespace Utils
     // Getting data labels...
     // DataLables = Vector<std::string>(N);
     DataLables.resize(N);
+    LabelIndex index; // Entered labels, so each duplicate check is O(1)
+    index.reset(DataLables);
     std::cout << "\nEntering data labels....\n";
     for (size_t i = 0; i < N; i++)
     {
@@ -232,7 +445,8 @@ namespace Utils
       // std::cin >> in;
 
       // std::cin.ignore();
-      DataLables[i] = readLabel(DataLables, msg);
+      DataLables[i] = readLabel(index, msg);
+      index.add(i);
     }
 
     clearTerminal();
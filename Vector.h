@@ -6,16 +6,86 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <utility>
 
 template <typename T>
 class Vector
 {
-  T *data;    // Pointer to the array of elements
+  T *data;    // Pointer to the array of elements (only the first `len` slots hold constructed elements)
   size_t cap; // Capacity of the vector (maximum number of elements it can hold)
   size_t len; // Current size of the vector (number of elements currently stored)
 
+  // Raw storage for `count` elements, nothing is constructed in it
+  static T *allocate(size_t count)
+  {
+    return count ? std::allocator<T>().allocate(count) : nullptr;
+  }
+
+  static void deallocate(T *storage, size_t count)
+  {
+    if (storage)
+      std::allocator<T>().deallocate(storage, count);
+  }
+
+  // Destroys the elements in [from, to)
+  static void destroy(T *from, T *to)
+  {
+    for (; from != to; ++from)
+      from->~T();
+  }
+
+  // Destroys every element and frees the storage
+  void release()
+  {
+    destroy(data, data + len);
+    deallocate(data, cap);
+    data = nullptr;
+    cap = 0;
+    len = 0;
+  }
+
+  /**
+   * @brief Moves the elements into new storage of `new_cap` slots (at least `len`).
+   *
+   * Elements are moved rather than copied (unless moving could throw and copying can't).
+   */
+  void reallocate(size_t new_cap)
+  {
+    T *new_data = allocate(new_cap);
+    size_t moved = 0;
+    try
+    {
+      for (; moved < len; ++moved)
+        new (new_data + moved) T(std::move_if_noexcept(data[moved]));
+    }
+    catch (...)
+    {
+      destroy(new_data, new_data + moved);
+      deallocate(new_data, new_cap);
+      throw;
+    }
+
+    destroy(data, data + len);
+    deallocate(data, cap);
+    data = new_data;
+    cap = new_cap;
+  }
+
+  // Capacity to grow to so that `needed` elements fit, doubling to keep appends amortized O(1)
+  size_t grownCapacity(size_t needed) const
+  {
+    size_t new_cap = (cap == 0) ? 1 : cap * 2;
+    return (needed > new_cap) ? needed : new_cap;
+  }
+
 public:
+  // Iterators are plain pointers into the elements
+  using iterator = T *;
+  using const_iterator = const T *;
+
   /**a
    * @brief Constructor to initialize  vector with a specified size.
    *
@@ -25,7 +95,19 @@ public:
    * @param initial_size The initial size of the vector (default is 0).
    */
   Vector(size_t initial_size = 0)
-      : data(initial_size ? new T[initial_size] : nullptr), cap(initial_size), len(initial_size) {}
+      : data(nullptr), cap(0), len(0)
+  {
+    // The destructor does not run if a constructor throws, so free what was built here
+    try
+    {
+      resize(initial_size);
+    }
+    catch (...)
+    {
+      release();
+      throw;
+    }
+  }
 
   /**
    * @brief Constructor to initialize a vector with a list of values.
@@ -35,12 +117,21 @@ public:
    * @param list An initializer list of elements.
    */
   Vector(std::initializer_list<T> list)
-      : data(new T[list.size()]), cap(list.size()), len(list.size())
+      : data(nullptr), cap(0), len(0)
   {
-    size_t i = 0;
-    for (const T &elem : list)
+    try
     {
-      data[i++] = elem;
+      reserve(list.size());
+      for (const T &elem : list)
+      {
+        new (data + len) T(elem);
+        ++len;
+      }
+    }
+    catch (...)
+    {
+      release();
+      throw;
     }
   }
 
@@ -51,7 +142,7 @@ public:
    */
   ~Vector()
   {
-    delete[] data;
+    release();
   }
 
   /**
@@ -62,11 +153,20 @@ public:
    * @param other The vector to copy from.
    */
   Vector(const Vector &other)
-      : data(other.len ? new T[other.len] : nullptr), cap(other.cap), len(other.len)
+      : data(nullptr), cap(0), len(0)
   {
-    for (size_t i = 0; i < len; ++i)
+    try
+    {
+      reserve(other.len);
+      for (; len < other.len; ++len)
+      {
+        new (data + len) T(other.data[len]);
+      }
+    }
+    catch (...)
     {
-      data[i] = other.data[i];
+      release();
+      throw;
     }
   }
 
@@ -82,18 +182,9 @@ public:
   {
     if (this != &other)
     {
-      // Clean up existing data
-      delete[] data;
-
-      // Copy new data
-      cap = other.cap;
-      len = other.len;
-      data = other.len ? new T[other.len] : nullptr;
-
-      for (size_t i = 0; i < len; ++i)
-      {
-        data[i] = other.data[i];
-      }
+      // Copy first, so this vector is unchanged if copying throws
+      Vector copy(other); // Only `len` elements are allocated
+      *this = std::move(copy);
     }
     return *this;
   }
@@ -126,7 +217,7 @@ public:
     if (this != &other)
     {
       // Clean up existing data
-      delete[] data;
+      release();
 
       // Transfer ownership
       data = other.data;
@@ -173,25 +264,51 @@ public:
     if (new_size > cap)
     {
       // Allocate new memory with some growth factor
-      size_t new_cap = (new_size > cap * 2) ? new_size : cap * 2;
-      if (new_cap == 0)
-        new_cap = 1;
+      reallocate(grownCapacity(new_size));
+    }
 
-      T *new_data = new T[new_cap];
-      for (size_t i = 0; i < len; ++i)
-      {
-        new_data[i] = data[i]; // Copy existing elements
-      }
-      delete[] data;
-      data = new_data;
-      cap = new_cap;
+    // Destroy the elements cut off when shrinking
+    if (new_size < len)
+    {
+      destroy(data + new_size, data + len);
+      len = new_size;
     }
+
     // Default-initialize new elements if resizing to a larger size
-    for (size_t i = len; i < new_size; ++i)
+    for (; len < new_size; ++len)
     {
-      data[i] = T();
+      new (data + len) T();
     }
-    len = new_size;
+  }
+
+  /**
+   * @brief Makes room for at least `new_cap` elements without changing the size.
+   *
+   * Appending up to that many elements then never reallocates.
+   *
+   * @param new_cap The number of elements to make room for.
+   */
+  void reserve(size_t new_cap)
+  {
+    if (new_cap > cap)
+      reallocate(new_cap);
+  }
+
+  /**
+   * @brief Frees the capacity that is not used by any element.
+   */
+  void shrink_to_fit()
+  {
+    if (cap > len)
+      reallocate(len);
+  }
+
+  /**
+   * @brief Get the number of elements the vector can hold before reallocating.
+   */
+  size_t capacity() const
+  {
+    return cap;
   }
 
   /**
@@ -240,20 +357,101 @@ public:
    */
   void push_back(const T &value)
   {
-    if (len >= cap)
+    emplace_back(value);
+  }
+
+  /**
+   * @brief Add a new element to the end of the vector, moving it in.
+   *
+   * @param value The value to be moved into the vector.
+   */
+  void push_back(T &&value)
+  {
+    emplace_back(std::move(value));
+  }
+
+  /**
+   * @brief Construct a new element in place at the end of the vector.
+   *
+   * If the current capacity is not sufficient, the vector's capacity is doubled first.
+   * The arguments may refer to elements of this vector.
+   *
+   * @param args The arguments passed to the element's constructor.
+   * @return A reference to the new element.
+   */
+  template <typename... Args>
+  T &emplace_back(Args &&...args)
+  {
+    if (len < cap)
     {
-      // Need to grow capacity
-      size_t new_cap = (cap == 0) ? 1 : cap * 2;
-      T *new_data = new T[new_cap];
-      for (size_t i = 0; i < len; ++i)
-      {
-        new_data[i] = data[i];
-      }
-      delete[] data;
-      data = new_data;
-      cap = new_cap;
+      new (data + len) T(std::forward<Args>(args)...);
+      return data[len++];
+    }
+
+    // Need to grow capacity: build the new element first, the arguments may live in the old storage
+    size_t new_cap = grownCapacity(len + 1);
+    T *new_data = allocate(new_cap);
+    try
+    {
+      new (new_data + len) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      deallocate(new_data, new_cap);
+      throw;
+    }
+
+    size_t moved = 0;
+    try
+    {
+      for (; moved < len; ++moved)
+        new (new_data + moved) T(std::move_if_noexcept(data[moved]));
+    }
+    catch (...)
+    {
+      destroy(new_data, new_data + moved);
+      new_data[len].~T();
+      deallocate(new_data, new_cap);
+      throw;
+    }
+
+    destroy(data, data + len);
+    deallocate(data, cap);
+    data = new_data;
+    cap = new_cap;
+    return data[len++];
+  }
+
+  /**
+   * @brief Access the last element of the vector.
+   *
+   * @return A reference to the last element.
+   * @throws std::out_of_range If the vector is empty.
+   */
+  T &back() const
+  {
+    if (len == 0)
+    {
+      throw std::out_of_range("Vector is empty in Vector::back");
     }
-    data[len++] = value;
+    return data[len - 1];
+  }
+
+  /**
+   * @brief Remove the last element of the vector.
+   *
+   * The capacity is kept, so the vector can be used as a stack without reallocating.
+   *
+   * @throws std::out_of_range If the vector is empty.
+   */
+  void pop_back()
+  {
+    if (len == 0)
+    {
+      throw std::out_of_range("Vector is empty in Vector::pop_back");
+    }
+    --len;
+    data[len].~T();
   }
 
   /**
@@ -290,9 +488,35 @@ public:
 
     for (size_t i = index; i < len - 1; ++i)
     {
-      data[i] = data[i + 1];
+      data[i] = std::move(data[i + 1]);
     }
 
     --len;
+    data[len].~T();
+  }
+
+  /**
+   * @brief Iterators over the elements, so a vector works with range-based for loops.
+   *
+   * They are invalidated when the vector reallocates (growing past its capacity).
+   */
+  iterator begin()
+  {
+    return data;
+  }
+
+  iterator end()
+  {
+    return data + len;
+  }
+
+  const_iterator begin() const
+  {
+    return data;
+  }
+
+  const_iterator end() const
+  {
+    return data + len;
   }
 };